@@ -11,5 +11,8 @@ const startScreenshotListeningConst = 'startScreenshotListening';
 const stopScreenshotListeningConst = 'stopScreenshotListening';
 const startScreenRecordingListeningConst = 'startScreenRecordingListening';
 const stopScreenRecordingListeningConst = 'stopScreenRecordingListening';
+const configureScreenRecordingDetectionConst =
+    'configureScreenRecordingDetection';
+const configureScreenshotDetectionConst = 'configureScreenshotDetection';
 const screenshotMethodChannel = "com.flutterplaza.no_screenshot_methods";
 const screenshotEventChannel = "com.flutterplaza.no_screenshot_streams";
@@ -1,5 +1,6 @@
 import 'dart:async';
 
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 
 import 'no_screenshot_platform_interface.dart';
@@ -169,6 +170,23 @@ class NoScreenshot implements NoScreenshotPlatform {
     return _instancePlatform.stopScreenRecordingListening();
   }
 
+  /// Tune how screen recording detection polls (Linux only)
+  @override
+  Future<void> configureScreenRecordingDetection(
+    RecordingDetectionConfig config,
+  ) {
+    return _instancePlatform.configureScreenRecordingDetection(config);
+  }
+
+  /// Set the gap that groups consecutive screenshots into a burst (Linux
+  /// only)
+  @override
+  Future<void> configureScreenshotDetection({
+    Duration burstGap = const Duration(seconds: 2),
+  }) {
+    return _instancePlatform.configureScreenshotDetection(burstGap: burstGap);
+  }
+
   @override
   bool operator ==(Object other) {
     return identical(this, other) ||
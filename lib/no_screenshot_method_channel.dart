@@ -3,6 +3,7 @@ import 'dart:convert';
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 import 'package:no_screenshot/constants.dart';
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 
 import 'no_screenshot_platform_interface.dart';
@@ -109,4 +110,32 @@ class MethodChannelNoScreenshot extends NoScreenshotPlatform {
   Future<void> stopScreenRecordingListening() {
     return methodChannel.invokeMethod<void>(stopScreenRecordingListeningConst);
   }
+
+  @override
+  Future<void> configureScreenRecordingDetection(
+    RecordingDetectionConfig config,
+  ) async {
+    try {
+      await methodChannel.invokeMethod<void>(
+        configureScreenRecordingDetectionConst,
+        config.toMap(),
+      );
+    } on MissingPluginException {
+      // Only Linux polls; elsewhere there is nothing to configure.
+    }
+  }
+
+  @override
+  Future<void> configureScreenshotDetection({
+    Duration burstGap = const Duration(seconds: 2),
+  }) async {
+    try {
+      await methodChannel.invokeMethod<void>(
+        configureScreenshotDetectionConst,
+        {'burst_gap_ms': burstGap.inMilliseconds},
+      );
+    } on MissingPluginException {
+      // Only Linux groups captures into bursts.
+    }
+  }
 }
@@ -1,3 +1,4 @@
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
@@ -117,4 +118,24 @@ abstract class NoScreenshotPlatform extends PlatformInterface {
       'stopScreenRecordingListening has not been implemented.',
     );
   }
+
+  /// Tune how screen recording detection polls where it has to
+  /// (see [RecordingDetectionConfig]).
+  Future<void> configureScreenRecordingDetection(
+    RecordingDetectionConfig config,
+  ) {
+    throw UnimplementedError(
+      'configureScreenRecordingDetection has not been implemented.',
+    );
+  }
+
+  /// Set the longest gap between two captures that still groups them into
+  /// one burst (see [ScreenshotSnapshot.burstCount]).
+  Future<void> configureScreenshotDetection({
+    Duration burstGap = const Duration(seconds: 2),
+  }) {
+    throw UnimplementedError(
+      'configureScreenshotDetection has not been implemented.',
+    );
+  }
 }
@@ -3,6 +3,7 @@ import 'dart:js_interop';
 
 import 'package:flutter_web_plugins/flutter_web_plugins.dart';
 import 'package:no_screenshot/no_screenshot_platform_interface.dart';
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 import 'package:web/web.dart' as web;
 
@@ -117,6 +118,16 @@ class NoScreenshotWeb extends NoScreenshotPlatform {
   @override
   Future<void> stopScreenRecordingListening() async {}
 
+  @override
+  Future<void> configureScreenRecordingDetection(
+    RecordingDetectionConfig config,
+  ) async {}
+
+  @override
+  Future<void> configureScreenshotDetection({
+    Duration burstGap = const Duration(seconds: 2),
+  }) async {}
+
   // ── Internal ───────────────────────────────────────────────────────
 
   void _enableProtection() {
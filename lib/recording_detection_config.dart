@@ -0,0 +1,84 @@
+import 'package:flutter/foundation.dart';
+
+/// Tunes how often screen recording detection polls when the platform
+/// offers no event source.
+///
+/// Only used on **Linux**, and only while detection has to poll the process
+/// list (no `CAP_NET_ADMIN` for process events). Polling runs at
+/// [minInterval] while the app window is focused, visible and protected,
+/// and after bursts of process activity. Otherwise it backs off
+/// exponentially up to [maxInterval]. A poll never runs more often than
+/// [cpuBudget] allows.
+///
+/// [deepScan] additionally inspects processes whose name matches no known
+/// recorder for capture devices and libraries, and flags processes attached
+/// to screen-sized shared memory segments (X11 MIT-SHM grabbers). It is
+/// heuristic, only sees the user's own processes, and is off by default.
+///
+/// [sessionOnly] scans only the processes of the user's login session (the
+/// systemd user slice) instead of every process on the machine. It helps on
+/// shared or multi-user hosts and falls back to a full scan where there is
+/// no user slice.
+@immutable
+class RecordingDetectionConfig {
+  /// Fastest polling interval.
+  final Duration minInterval;
+
+  /// Slowest polling interval, reached while the app is idle, hidden or
+  /// unprotected.
+  final Duration maxInterval;
+
+  /// Fraction of one CPU core polling may use, e.g. `0.01` for 1%.
+  final double cpuBudget;
+
+  /// Whether to inspect unrecognized processes for screen capture
+  /// capability.
+  final bool deepScan;
+
+  /// Whether to scan only the user's login session.
+  final bool sessionOnly;
+
+  const RecordingDetectionConfig({
+    this.minInterval = const Duration(seconds: 1),
+    this.maxInterval = const Duration(seconds: 16),
+    this.cpuBudget = 0.01,
+    this.deepScan = false,
+    this.sessionOnly = false,
+  });
+
+  Map<String, dynamic> toMap() {
+    return {
+      'min_interval_ms': minInterval.inMilliseconds,
+      'max_interval_ms': maxInterval.inMilliseconds,
+      'cpu_budget': cpuBudget,
+      'deep_scan': deepScan,
+      'session_only': sessionOnly,
+    };
+  }
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+
+    return other is RecordingDetectionConfig &&
+        other.minInterval == minInterval &&
+        other.maxInterval == maxInterval &&
+        other.cpuBudget == cpuBudget &&
+        other.deepScan == deepScan &&
+        other.sessionOnly == sessionOnly;
+  }
+
+  @override
+  int get hashCode {
+    return minInterval.hashCode ^
+        maxInterval.hashCode ^
+        cpuBudget.hashCode ^
+        deepScan.hashCode ^
+        sessionOnly.hashCode;
+  }
+
+  @override
+  String toString() {
+    return 'RecordingDetectionConfig(minInterval: $minInterval, maxInterval: $maxInterval, cpuBudget: $cpuBudget, deepScan: $deepScan, sessionOnly: $sessionOnly)';
+  }
+}
@@ -1,3 +1,5 @@
+import 'package:flutter/foundation.dart';
+
 class ScreenshotSnapshot {
   /// File path of the captured screenshot.
   ///
@@ -22,6 +24,35 @@ class ScreenshotSnapshot {
   /// Empty string means unknown or not applicable.
   final String sourceApp;
 
+  /// Number of consecutive captures from the same tool grouped into this
+  /// event.
+  ///
+  /// Only reported on **Linux**, where captures taken within a short gap of
+  /// each other are sessionized into a burst: the first capture is reported
+  /// immediately with `burstCount == 1`, and — if more captures follow — a
+  /// single closing event with [isBurstClosed] set summarises the burst.
+  /// `0` means the platform does not group captures.
+  final int burstCount;
+
+  /// Milliseconds since epoch of the first capture in the burst (`0` = none).
+  final int burstFirstTimestamp;
+
+  /// Milliseconds since epoch of the last capture in the burst (`0` = none).
+  final int burstLastTimestamp;
+
+  /// Paths of the first captures in the burst (bounded — a long burst only
+  /// lists its first few files; use [burstCount] for the total).
+  final List<String> burstPaths;
+
+  /// Whether this is the closing event of a burst.
+  final bool isBurstClosed;
+
+  /// Names of the screen recorders currently running, oldest first.
+  ///
+  /// Only reported on **Linux**; empty elsewhere or when none are running.
+  /// [sourceApp] names the most recently started one.
+  final List<String> activeRecorders;
+
   ScreenshotSnapshot({
     required this.screenshotPath,
     required this.isScreenshotProtectionOn,
@@ -29,6 +60,12 @@ class ScreenshotSnapshot {
     this.isScreenRecording = false,
     this.timestamp = 0,
     this.sourceApp = '',
+    this.burstCount = 0,
+    this.burstFirstTimestamp = 0,
+    this.burstLastTimestamp = 0,
+    this.burstPaths = const [],
+    this.isBurstClosed = false,
+    this.activeRecorders = const [],
   });
 
   factory ScreenshotSnapshot.fromMap(Map<String, dynamic> map) {
@@ -39,6 +76,15 @@ class ScreenshotSnapshot {
       isScreenRecording: map['is_screen_recording'] as bool? ?? false,
       timestamp: map['timestamp'] as int? ?? 0,
       sourceApp: map['source_app'] as String? ?? '',
+      burstCount: map['burst_count'] as int? ?? 0,
+      burstFirstTimestamp: map['burst_first_timestamp'] as int? ?? 0,
+      burstLastTimestamp: map['burst_last_timestamp'] as int? ?? 0,
+      burstPaths:
+          (map['burst_paths'] as List<dynamic>?)?.cast<String>() ?? const [],
+      isBurstClosed: map['is_burst_closed'] as bool? ?? false,
+      activeRecorders:
+          (map['active_recorders'] as List<dynamic>?)?.cast<String>() ??
+              const [],
     );
   }
 
@@ -50,12 +96,18 @@ class ScreenshotSnapshot {
       'is_screen_recording': isScreenRecording,
       'timestamp': timestamp,
       'source_app': sourceApp,
+      'burst_count': burstCount,
+      'burst_first_timestamp': burstFirstTimestamp,
+      'burst_last_timestamp': burstLastTimestamp,
+      'burst_paths': burstPaths,
+      'is_burst_closed': isBurstClosed,
+      'active_recorders': activeRecorders,
     };
   }
 
   @override
   String toString() {
-    return 'ScreenshotSnapshot(\nscreenshotPath: $screenshotPath, \nisScreenshotProtectionOn: $isScreenshotProtectionOn, \nwasScreenshotTaken: $wasScreenshotTaken, \nisScreenRecording: $isScreenRecording, \ntimestamp: $timestamp, \nsourceApp: $sourceApp\n)';
+    return 'ScreenshotSnapshot(\nscreenshotPath: $screenshotPath, \nisScreenshotProtectionOn: $isScreenshotProtectionOn, \nwasScreenshotTaken: $wasScreenshotTaken, \nisScreenRecording: $isScreenRecording, \ntimestamp: $timestamp, \nsourceApp: $sourceApp, \nburstCount: $burstCount, \nburstFirstTimestamp: $burstFirstTimestamp, \nburstLastTimestamp: $burstLastTimestamp, \nburstPaths: $burstPaths, \nisBurstClosed: $isBurstClosed, \nactiveRecorders: $activeRecorders\n)';
   }
 
   @override
@@ -68,7 +120,13 @@ class ScreenshotSnapshot {
         other.wasScreenshotTaken == wasScreenshotTaken &&
         other.isScreenRecording == isScreenRecording &&
         other.timestamp == timestamp &&
-        other.sourceApp == sourceApp;
+        other.sourceApp == sourceApp &&
+        other.burstCount == burstCount &&
+        other.burstFirstTimestamp == burstFirstTimestamp &&
+        other.burstLastTimestamp == burstLastTimestamp &&
+        listEquals(other.burstPaths, burstPaths) &&
+        other.isBurstClosed == isBurstClosed &&
+        listEquals(other.activeRecorders, activeRecorders);
   }
 
   @override
@@ -78,6 +136,12 @@ class ScreenshotSnapshot {
         wasScreenshotTaken.hashCode ^
         isScreenRecording.hashCode ^
         timestamp.hashCode ^
-        sourceApp.hashCode;
+        sourceApp.hashCode ^
+        burstCount.hashCode ^
+        burstFirstTimestamp.hashCode ^
+        burstLastTimestamp.hashCode ^
+        Object.hashAll(burstPaths) ^
+        isBurstClosed.hashCode ^
+        Object.hashAll(activeRecorders);
   }
 }
@@ -0,0 +1,77 @@
+#include "capture_args.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Input formats that grab the screen.
+static const gchar* const kScreenGrabFormats[] = {
+    "x11grab",
+    "xcbgrab",
+    "kmsgrab",
+    "pipewiregrab",
+    "fbdev",
+    NULL,
+};
+
+static gboolean is_screen_grab_format(const gchar* format) {
+  for (int i = 0; kScreenGrabFormats[i] != NULL; i++) {
+    if (strcmp(format, kScreenGrabFormats[i]) == 0) return TRUE;
+  }
+  return FALSE;
+}
+
+// v4l2loopback devices are virtual; real cameras hang off a bus.
+gboolean capture_args_is_loopback_device(const gchar* path) {
+  if (!g_path_is_absolute(path)) return FALSE;
+  gchar resolved[PATH_MAX];
+  if (realpath(path, resolved) == NULL) return FALSE;
+  if (!g_str_has_prefix(resolved, "/dev/video")) return FALSE;
+
+  g_autofree gchar* sysfs = g_strconcat(
+      "/sys/class/video4linux/", resolved + strlen("/dev/"), NULL);
+  gchar device[PATH_MAX];
+  if (realpath(sysfs, device) == NULL) return FALSE;
+  return strstr(device, "/devices/virtual/") != NULL;
+}
+
+static gboolean is_loopback_input(const gchar* input, const gchar* cwd) {
+  if (g_path_is_absolute(input)) {
+    return capture_args_is_loopback_device(input);
+  }
+  if (cwd == NULL) return FALSE;
+  g_autofree gchar* path = g_build_filename(cwd, input, NULL);
+  return capture_args_is_loopback_device(path);
+}
+
+gboolean capture_args_is_screen_capture(const gchar* argv,
+                                        gsize length,
+                                        const gchar* cwd) {
+  const gchar* end = argv + length;
+  // "-f <format>" applies to the next "-i"; an -f with no -i after it
+  // names the output format (e.g. writing *to* a loopback device).
+  const gchar* format = NULL;
+
+  for (const gchar* arg = argv; arg < end; arg += strlen(arg) + 1) {
+    const gchar* value = arg + strlen(arg) + 1;
+    if (value >= end) break;
+
+    if (strcmp(arg, "-f") == 0) {
+      format = value;
+    } else if (strcmp(arg, "-i") == 0) {
+      if (format != NULL) {
+        if (is_screen_grab_format(format)) return TRUE;
+        if ((strcmp(format, "v4l2") == 0 ||
+             strcmp(format, "video4linux2") == 0) &&
+            is_loopback_input(value, cwd)) {
+          return TRUE;
+        }
+      }
+      format = NULL;
+    } else {
+      continue;
+    }
+    arg = value;  // Skip the option's value.
+  }
+  return FALSE;
+}
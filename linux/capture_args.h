@@ -0,0 +1,25 @@
+#ifndef CAPTURE_ARGS_H_
+#define CAPTURE_ARGS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Classifies the command line of a general-purpose media tool (ffmpeg) by
+// its inputs: returns TRUE if it reads from a screen grabber (x11grab,
+// kmsgrab, pipewiregrab, fbdev) or a v4l2 loopback device. |argv| is the
+// NUL-separated content of /proc/<pid>/cmdline, |length| bytes long.
+// Relative input paths are resolved against |cwd|, the process's working
+// directory (the target of /proc/<pid>/cwd), and never match if it is NULL.
+gboolean capture_args_is_screen_capture(const gchar* argv,
+                                        gsize length,
+                                        const gchar* cwd);
+
+// Returns TRUE if |path| is (a link to) a v4l2loopback video device. A
+// relative |path| is never one, as it would resolve against our own
+// working directory.
+gboolean capture_args_is_loopback_device(const gchar* path);
+
+G_END_DECLS
+
+#endif  // CAPTURE_ARGS_H_
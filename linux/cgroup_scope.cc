@@ -0,0 +1,137 @@
+#include "cgroup_scope.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dir_scan.h"
+
+#define PROCS_CHUNK_SIZE 4096
+
+// Returns the mount point of the cgroup2 hierarchy — /sys/fs/cgroup, or
+// /sys/fs/cgroup/unified on hybrid hosts — or NULL.
+static gchar* find_cgroup2_mount() {
+  g_autofree gchar* mountinfo = NULL;
+  if (!g_file_get_contents("/proc/self/mountinfo", &mountinfo, NULL, NULL)) {
+    return NULL;
+  }
+  for (gchar* line = mountinfo; line != NULL && *line != '\0';) {
+    gchar* next = strchr(line, '\n');
+    if (next != NULL) *next++ = '\0';
+
+    // "id parent major:minor root mount-point options ... - fstype ..."
+    const gchar* separator = strstr(line, " - ");
+    if (separator != NULL &&
+        g_str_has_prefix(separator + strlen(" - "), "cgroup2 ")) {
+      const gchar* field = line;
+      for (int i = 0; i < 4 && field != NULL; i++) {
+        field = strchr(field, ' ');
+        if (field != NULL) field++;
+      }
+      if (field != NULL) {
+        return g_strndup(field, strchrnul(field, ' ') - field);
+      }
+    }
+    line = next;
+  }
+  return NULL;
+}
+
+gchar* cgroup_scope_find_user_slice() {
+  g_autofree gchar* cgroups = NULL;
+  if (!g_file_get_contents("/proc/self/cgroup", &cgroups, NULL, NULL)) {
+    return NULL;
+  }
+  // The unified hierarchy is the "0::<path>" line.
+  const gchar* line = g_str_has_prefix(cgroups, "0::")
+                          ? cgroups
+                          : strstr(cgroups, "\n0::");
+  if (line == NULL) return NULL;
+  if (line[0] == '\n') line++;
+  const gchar* path = line + strlen("0::");
+  const gchar* path_end = strchrnul(path, '\n');
+
+  g_autofree gchar* slice = g_strdup_printf("/user-%u.slice", getuid());
+  const gchar* match = g_strstr_len(path, path_end - path, slice);
+  if (match == NULL) return NULL;
+  const gchar* slice_end = match + strlen(slice);
+  if (*slice_end != '/' && slice_end != path_end) return NULL;
+
+  g_autofree gchar* mount = find_cgroup2_mount();
+  if (mount == NULL) return NULL;
+  g_autofree gchar* relative = g_strndup(path, slice_end - path);
+  return g_strconcat(mount, relative, NULL);
+}
+
+// Parses the newline-separated PIDs of |dir_fd|/cgroup.procs a chunk at a
+// time, carrying a partial number across chunk boundaries.
+static gboolean read_procs(int dir_fd, CgroupPidFunc func, gpointer user_data) {
+  int fd = openat(dir_fd, "cgroup.procs", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return errno == ENOENT;  // Removed during the walk.
+
+  gchar chunk[PROCS_CHUNK_SIZE];
+  gint pid = 0;
+  gboolean has_digits = FALSE;
+  gboolean ok = TRUE;
+  for (;;) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      ok = errno == ENODEV;  // Removed while reading.
+      break;
+    }
+    if (n == 0) break;
+    for (ssize_t i = 0; i < n; i++) {
+      if (chunk[i] >= '0' && chunk[i] <= '9') {
+        pid = pid * 10 + (chunk[i] - '0');
+        has_digits = TRUE;
+      } else if (has_digits) {
+        func(pid, user_data);
+        pid = 0;
+        has_digits = FALSE;
+      }
+    }
+  }
+  close(fd);
+  if (ok && has_digits) func(pid, user_data);
+  return ok;
+}
+
+typedef struct {
+  int dir_fd;
+  CgroupPidFunc func;
+  gpointer user_data;
+  gboolean ok;
+} CgroupWalk;
+
+static gboolean walk_cgroup(int dir_fd, CgroupPidFunc func, gpointer data);
+
+static gboolean on_cgroup_entry(const gchar* name,
+                                guchar d_type,
+                                guint64 inode,
+                                gpointer user_data) {
+  CgroupWalk* walk = (CgroupWalk*)user_data;
+  if (d_type != DT_DIR && d_type != DT_UNKNOWN) return TRUE;
+
+  int child_fd =
+      openat(walk->dir_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (child_fd < 0) return TRUE;  // A file, or removed during the walk.
+  if (!walk_cgroup(child_fd, walk->func, walk->user_data)) walk->ok = FALSE;
+  close(child_fd);
+  return TRUE;
+}
+
+static gboolean walk_cgroup(int dir_fd, CgroupPidFunc func, gpointer data) {
+  CgroupWalk walk = {dir_fd, func, data, TRUE};
+  if (!read_procs(dir_fd, func, data)) return FALSE;
+  if (!dir_scan(dir_fd, on_cgroup_entry, &walk)) return FALSE;
+  return walk.ok;
+}
+
+gboolean cgroup_scope_foreach_pid(int dir_fd,
+                                  CgroupPidFunc func,
+                                  gpointer user_data) {
+  return walk_cgroup(dir_fd, func, user_data);
+}
@@ -0,0 +1,26 @@
+#ifndef CGROUP_SCOPE_H_
+#define CGROUP_SCOPE_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Called for each PID listed in a cgroup.procs file.
+typedef void (*CgroupPidFunc)(gint pid, gpointer user_data);
+
+// Returns the cgroup2 directory of the systemd user slice this process runs
+// in (e.g. "/sys/fs/cgroup/user.slice/user-1000.slice"), which holds the
+// login session and every app the user launched. NULL without a unified
+// cgroup hierarchy or outside a user slice (containers, non-systemd hosts).
+gchar* cgroup_scope_find_user_slice();
+
+// Lists the PIDs of the cgroup |dir_fd| and all its descendants, reading
+// one cgroup.procs file per cgroup. Returns FALSE if a cgroup could not be
+// read.
+gboolean cgroup_scope_foreach_pid(int dir_fd,
+                                  CgroupPidFunc func,
+                                  gpointer user_data);
+
+G_END_DECLS
+
+#endif  // CGROUP_SCOPE_H_
@@ -0,0 +1,267 @@
+#include "deep_scan.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "capture_args.h"
+
+#define TICK_INTERVAL_MS 50
+// Work per tick; the main loop never stalls longer than this.
+#define TICK_BUDGET_US 2000
+#define MAPS_CHUNK_SIZE 4096
+#define COMM_MAX 16
+
+// Mapped libraries that only screen capture tools load.
+static const gchar* const kCaptureLibraries[] = {
+    "/libobs.so",
+    "/libgstximagesrc.so",
+    NULL,
+};
+
+// A native PipeWire client. Weak on its own — browsers load it for audio —
+// but together with a KMS device it points to a screen grabber. X11 and
+// PipeWire sockets are not used: every client has one, and the peer of a
+// connected unix socket is not visible in /proc.
+#define PIPEWIRE_LIBRARY "/libpipewire-0.3.so"
+#define KMS_DEVICE_PREFIX "/dev/dri/card"
+#define VIDEO_DEVICE_PREFIX "/dev/video"
+
+typedef enum {
+  STAGE_FDS,
+  STAGE_MAPS,
+} ScanStage;
+
+typedef struct {
+  gint pid;
+  guint64 start_time;
+  gchar comm[COMM_MAX];
+} ScanRequest;
+
+struct _DeepScan {
+  ProcScanner* scanner;
+  DeepScanResultFunc func;
+  gpointer user_data;
+
+  GQueue queue;        // ScanRequest*, oldest first.
+  GHashTable* queued;  // pid → GList* link in |queue|
+  guint timer_id;
+
+  // Cursor of the scan in progress, kept across ticks.
+  ScanRequest* current;
+  ScanStage stage;
+  DIR* fd_dir;
+  int maps_fd;
+  GString* maps_line;  // Partial line carried over between chunks.
+  gboolean has_capture_signal;
+  gboolean has_kms_device;
+  gboolean has_pipewire;
+};
+
+static void reset_cursor(DeepScan* self) {
+  g_clear_pointer(&self->current, g_free);
+  if (self->fd_dir != NULL) {
+    closedir(self->fd_dir);
+    self->fd_dir = NULL;
+  }
+  if (self->maps_fd >= 0) {
+    close(self->maps_fd);
+    self->maps_fd = -1;
+  }
+  g_string_truncate(self->maps_line, 0);
+  self->stage = STAGE_FDS;
+  self->has_capture_signal = FALSE;
+  self->has_kms_device = FALSE;
+  self->has_pipewire = FALSE;
+}
+
+static gboolean is_over_budget(gint64 deadline_us) {
+  return g_get_monotonic_time() >= deadline_us;
+}
+
+static void check_fd_target(DeepScan* self, const gchar* target) {
+  if (g_str_has_prefix(target, KMS_DEVICE_PREFIX)) {
+    self->has_kms_device = TRUE;
+  } else if (g_str_has_prefix(target, VIDEO_DEVICE_PREFIX) &&
+             capture_args_is_loopback_device(target)) {
+    self->has_capture_signal = TRUE;
+  }
+}
+
+static void check_maps_line(DeepScan* self, const gchar* line) {
+  const gchar* path = strchr(line, '/');
+  if (path == NULL) return;  // Anonymous mapping.
+  for (int i = 0; kCaptureLibraries[i] != NULL; i++) {
+    if (strstr(path, kCaptureLibraries[i]) != NULL) {
+      self->has_capture_signal = TRUE;
+      return;
+    }
+  }
+  if (strstr(path, PIPEWIRE_LIBRARY) != NULL) self->has_pipewire = TRUE;
+}
+
+// Walks /proc/<pid>/fd. Returns TRUE once the stage is complete.
+static gboolean scan_fds(DeepScan* self, gint64 deadline_us) {
+  if (self->fd_dir == NULL) {
+    int fd = proc_scanner_open(self->scanner, self->current->pid, "fd",
+                               O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return TRUE;  // Gone, or another user's process.
+    self->fd_dir = fdopendir(fd);
+    if (self->fd_dir == NULL) {
+      close(fd);
+      return TRUE;
+    }
+  }
+
+  while (!is_over_budget(deadline_us)) {
+    struct dirent* entry = readdir(self->fd_dir);
+    if (entry == NULL) return TRUE;
+    if (entry->d_name[0] == '.') continue;
+
+    gchar target[PATH_MAX];
+    gssize n = readlinkat(dirfd(self->fd_dir), entry->d_name, target,
+                          sizeof(target) - 1);
+    if (n <= 0) continue;
+    target[n] = '\0';
+    check_fd_target(self, target);
+    if (self->has_capture_signal) return TRUE;
+  }
+  return FALSE;
+}
+
+// Reads /proc/<pid>/maps a chunk at a time. Returns TRUE once the stage is
+// complete.
+static gboolean scan_maps(DeepScan* self, gint64 deadline_us) {
+  if (self->maps_fd < 0) {
+    self->maps_fd =
+        proc_scanner_open(self->scanner, self->current->pid, "maps", O_RDONLY);
+    if (self->maps_fd < 0) return TRUE;
+  }
+
+  gchar chunk[MAPS_CHUNK_SIZE];
+  while (!is_over_budget(deadline_us)) {
+    gssize n = read(self->maps_fd, chunk, sizeof(chunk));
+    if (n <= 0) return TRUE;
+
+    const gchar* start = chunk;
+    const gchar* end = chunk + n;
+    const gchar* newline;
+    while ((newline = (const gchar*)memchr(start, '\n', end - start)) !=
+           NULL) {
+      g_string_append_len(self->maps_line, start, newline - start);
+      check_maps_line(self, self->maps_line->str);
+      g_string_truncate(self->maps_line, 0);
+      if (self->has_capture_signal) return TRUE;
+      start = newline + 1;
+    }
+    g_string_append_len(self->maps_line, start, end - start);
+  }
+  return FALSE;
+}
+
+// Advances the current scan. Returns TRUE once it has a result.
+static gboolean step(DeepScan* self, gint64 deadline_us) {
+  if (self->stage == STAGE_FDS) {
+    if (!scan_fds(self, deadline_us)) return FALSE;
+    if (self->has_capture_signal) return TRUE;
+    self->stage = STAGE_MAPS;
+  }
+  return scan_maps(self, deadline_us);
+}
+
+static gboolean start_next(DeepScan* self) {
+  ScanRequest* request = (ScanRequest*)g_queue_pop_head(&self->queue);
+  if (request == NULL) return FALSE;
+  g_hash_table_remove(self->queued, GINT_TO_POINTER(request->pid));
+  self->current = request;
+  return TRUE;
+}
+
+static gboolean on_tick(gpointer user_data) {
+  DeepScan* self = (DeepScan*)user_data;
+  gint64 deadline_us = g_get_monotonic_time() + TICK_BUDGET_US;
+
+  while (!is_over_budget(deadline_us)) {
+    if (self->current == NULL && !start_next(self)) {
+      self->timer_id = 0;  // Removed by returning G_SOURCE_REMOVE.
+      return G_SOURCE_REMOVE;
+    }
+    if (!step(self, deadline_us)) break;
+
+    gboolean is_capture = self->has_capture_signal ||
+                          (self->has_kms_device && self->has_pipewire);
+    ScanRequest* done = self->current;
+    self->current = NULL;
+    reset_cursor(self);
+    self->func(done->pid, done->start_time, done->comm, is_capture,
+               self->user_data);
+    g_free(done);
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+DeepScan* deep_scan_new(ProcScanner* scanner,
+                        DeepScanResultFunc func,
+                        gpointer user_data) {
+  DeepScan* self = g_new0(DeepScan, 1);
+  self->scanner = scanner;
+  self->func = func;
+  self->user_data = user_data;
+  g_queue_init(&self->queue);
+  self->queued = g_hash_table_new(g_direct_hash, g_direct_equal);
+  self->maps_fd = -1;
+  self->maps_line = g_string_new(NULL);
+  return self;
+}
+
+void deep_scan_free(DeepScan* self) {
+  if (self == NULL) return;
+  deep_scan_clear(self);
+  g_hash_table_unref(self->queued);
+  g_string_free(self->maps_line, TRUE);
+  g_free(self);
+}
+
+void deep_scan_queue(DeepScan* self,
+                     gint pid,
+                     guint64 start_time,
+                     const gchar* comm) {
+  deep_scan_cancel(self, pid);
+
+  ScanRequest* request = g_new0(ScanRequest, 1);
+  request->pid = pid;
+  request->start_time = start_time;
+  g_strlcpy(request->comm, comm, sizeof(request->comm));
+  g_queue_push_tail(&self->queue, request);
+  g_hash_table_insert(self->queued, GINT_TO_POINTER(pid),
+                      self->queue.tail);
+
+  if (self->timer_id == 0) {
+    self->timer_id = g_timeout_add(TICK_INTERVAL_MS, on_tick, self);
+  }
+}
+
+void deep_scan_cancel(DeepScan* self, gint pid) {
+  GList* link =
+      (GList*)g_hash_table_lookup(self->queued, GINT_TO_POINTER(pid));
+  if (link != NULL) {
+    g_free(link->data);
+    g_queue_delete_link(&self->queue, link);
+    g_hash_table_remove(self->queued, GINT_TO_POINTER(pid));
+  }
+  if (self->current != NULL && self->current->pid == pid) {
+    reset_cursor(self);
+  }
+}
+
+void deep_scan_clear(DeepScan* self) {
+  if (self->timer_id != 0) {
+    g_source_remove(self->timer_id);
+    self->timer_id = 0;
+  }
+  reset_cursor(self);
+  g_queue_clear_full(&self->queue, g_free);
+  g_hash_table_remove_all(self->queued);
+}
@@ -0,0 +1,44 @@
+#ifndef DEEP_SCAN_H_
+#define DEEP_SCAN_H_
+
+#include <glib.h>
+
+#include "proc_scanner.h"
+
+G_BEGIN_DECLS
+
+// Examines processes for screen capture capability regardless of their
+// name: open fds (/dev/dri/card*, v4l2loopback devices) and mapped
+// libraries (libobs, libpipewire). Work is spread over short ticks with a
+// strict time budget; a process whose scan does not fit in one tick is
+// resumed in the next.
+typedef struct _DeepScan DeepScan;
+
+// Reports a finished scan of |pid|.
+typedef void (*DeepScanResultFunc)(gint pid,
+                                   guint64 start_time,
+                                   const gchar* comm,
+                                   gboolean is_capture,
+                                   gpointer user_data);
+
+// |scanner| provides access to /proc and must outlive the deep scan.
+DeepScan* deep_scan_new(ProcScanner* scanner,
+                        DeepScanResultFunc func,
+                        gpointer user_data);
+void deep_scan_free(DeepScan* self);
+
+// Queues |pid| for scanning, replacing any queued or running scan of it.
+void deep_scan_queue(DeepScan* self,
+                     gint pid,
+                     guint64 start_time,
+                     const gchar* comm);
+
+// Drops any queued or running scan of |pid|, e.g. after it exited.
+void deep_scan_cancel(DeepScan* self, gint pid);
+
+// Drops all queued and running scans.
+void deep_scan_clear(DeepScan* self);
+
+G_END_DECLS
+
+#endif  // DEEP_SCAN_H_
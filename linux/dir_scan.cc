@@ -0,0 +1,42 @@
+#include "dir_scan.h"
+
+#include <dirent.h>
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define DIR_SCAN_BUFFER_SIZE (32 * 1024)
+
+// Kernel layout of the records returned by getdents64.
+struct linux_dirent64 {
+  guint64 d_ino;
+  gint64 d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+gboolean dir_scan(int dir_fd, DirScanFunc func, gpointer user_data) {
+  if (lseek(dir_fd, 0, SEEK_SET) < 0) return FALSE;
+
+  // 8-byte aligned — the kernel writes 64-bit fields into it.
+  guint64 buffer[DIR_SCAN_BUFFER_SIZE / sizeof(guint64)];
+  for (;;) {
+    long n = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer));
+    if (n < 0) return FALSE;
+    if (n == 0) return TRUE;
+
+    for (long offset = 0; offset < n;) {
+      struct linux_dirent64* entry =
+          (struct linux_dirent64*)((gchar*)buffer + offset);
+      offset += entry->d_reclen;
+
+      const gchar* name = entry->d_name;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+      if (!func(name, entry->d_type, entry->d_ino, user_data)) return TRUE;
+    }
+  }
+}
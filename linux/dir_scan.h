@@ -0,0 +1,24 @@
+#ifndef DIR_SCAN_H_
+#define DIR_SCAN_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Called for each entry of a directory (excluding "." and ".."). |d_type| is
+// the DT_* value reported by the file system (DT_UNKNOWN if not provided)
+// and |inode| the entry's inode number. Return FALSE to stop the scan early.
+typedef gboolean (*DirScanFunc)(const gchar* name,
+                                guchar d_type,
+                                guint64 inode,
+                                gpointer user_data);
+
+// Iterates over the open directory |dir_fd| from the start, reading entries
+// in large batches with getdents64 — one syscall per few hundred entries
+// instead of readdir's per-call overhead and allocation. Returns FALSE if
+// the directory could not be read.
+gboolean dir_scan(int dir_fd, DirScanFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif  // DIR_SCAN_H_
@@ -0,0 +1,484 @@
+#include "loopback_monitor.h"
+
+#include <gio/gio.h>
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/netlink.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "capture_args.h"
+#include "dir_scan.h"
+
+#define VIDEO4LINUX_CLASS "/sys/class/video4linux"
+#define VIRTUAL_DEVPATH_PREFIX "/devices/virtual/"
+// Kernel uevents, as opposed to udev's processed ones on group 2.
+#define UEVENT_GROUP_KERNEL 1
+#define UEVENT_BUFFER_SIZE 8192
+#define INOTIFY_BUFFER_SIZE 4096
+// Opens and closes are coalesced, and short-lived probes (udev, PipeWire
+// enumerating cameras) are over before the holders are looked up.
+#define HOLDER_CHECK_DELAY_MS 250
+
+struct _LoopbackMonitor {
+  LoopbackHolderCallback callback;
+  gpointer user_data;
+
+  int uevent_fd;
+  guint uevent_watch_id;
+  int inotify_fd;
+  guint inotify_watch_id;
+  int proc_fd;
+  guint check_timer_id;
+  // Set while a lookup runs on a worker thread.
+  GCancellable* check_cancellable;
+  gboolean is_recheck_needed;
+
+  GHashTable* devices;  // "/dev/videoN" → inotify watch descriptor
+  GHashTable* holders;  // pid → comm
+};
+
+// What a holder lookup needs, copied for the worker thread.
+typedef struct {
+  int proc_fd;
+  GHashTable* devices;  // Set of "/dev/videoN".
+} HolderRequest;
+
+// State of one holder lookup over /proc.
+typedef struct {
+  const HolderRequest* request;
+  GCancellable* cancellable;
+  GHashTable* holders;
+  int fd_dir;
+  gboolean is_holding;
+} HolderSearch;
+
+// Returns the watch descriptor, or -1 — e.g. for a new node that udev has
+// not yet given its final permissions.
+static int watch_device(LoopbackMonitor* self, const gchar* path) {
+  return inotify_add_watch(self->inotify_fd, path, IN_OPEN | IN_CLOSE);
+}
+
+static void add_device(LoopbackMonitor* self, const gchar* path) {
+  if (g_hash_table_contains(self->devices, path)) return;
+  g_hash_table_insert(self->devices, g_strdup(path),
+                      GINT_TO_POINTER(watch_device(self, path)));
+}
+
+static void remove_device(LoopbackMonitor* self, const gchar* path) {
+  gpointer wd;
+  if (!g_hash_table_lookup_extended(self->devices, path, NULL, &wd)) return;
+  if (GPOINTER_TO_INT(wd) >= 0) {
+    inotify_rm_watch(self->inotify_fd, GPOINTER_TO_INT(wd));
+  }
+  g_hash_table_remove(self->devices, path);
+}
+
+static gboolean on_video_device(const gchar* name,
+                                guchar d_type,
+                                guint64 inode,
+                                gpointer user_data) {
+  LoopbackMonitor* self = (LoopbackMonitor*)user_data;
+  g_autofree gchar* path = g_strconcat("/dev/", name, NULL);
+  if (capture_args_is_loopback_device(path)) add_device(self, path);
+  return TRUE;
+}
+
+// Replaces the device set with the loopback devices sysfs lists now.
+static void enumerate_devices(LoopbackMonitor* self) {
+  GHashTableIter iter;
+  gpointer wd;
+  g_hash_table_iter_init(&iter, self->devices);
+  while (g_hash_table_iter_next(&iter, NULL, &wd)) {
+    if (GPOINTER_TO_INT(wd) >= 0) {
+      inotify_rm_watch(self->inotify_fd, GPOINTER_TO_INT(wd));
+    }
+  }
+  g_hash_table_remove_all(self->devices);
+
+  int fd = open(VIDEO4LINUX_CLASS, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) return;  // No video devices at all.
+  dir_scan(fd, on_video_device, self);
+  close(fd);
+}
+
+// ---------------------------------------------------------------------------
+// Holder lookup
+// ---------------------------------------------------------------------------
+
+static void holder_request_free(gpointer data) {
+  HolderRequest* request = (HolderRequest*)data;
+  if (request->proc_fd >= 0) close(request->proc_fd);
+  g_hash_table_unref(request->devices);
+  g_free(request);
+}
+
+// Runs on the worker thread.
+static gboolean on_fd_entry(const gchar* name,
+                            guchar d_type,
+                            guint64 inode,
+                            gpointer user_data) {
+  HolderSearch* search = (HolderSearch*)user_data;
+  gchar target[PATH_MAX];
+  ssize_t n = readlinkat(search->fd_dir, name, target, sizeof(target) - 1);
+  if (n <= 0) return TRUE;
+  target[n] = '\0';
+  if (g_hash_table_contains(search->request->devices, target)) {
+    search->is_holding = TRUE;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Runs on the worker thread.
+static gboolean on_proc_entry(const gchar* name,
+                              guchar d_type,
+                              guint64 inode,
+                              gpointer user_data) {
+  HolderSearch* search = (HolderSearch*)user_data;
+  if (g_cancellable_is_cancelled(search->cancellable)) return FALSE;
+  if (!g_ascii_isdigit(name[0])) return TRUE;
+  gint pid = atoi(name);
+  if (pid == getpid()) return TRUE;
+
+  g_autofree gchar* fd_path = g_strconcat(name, "/fd", NULL);
+  search->fd_dir = openat(search->request->proc_fd, fd_path,
+                          O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (search->fd_dir < 0) return TRUE;  // Gone, or another user's process.
+  search->is_holding = FALSE;
+  dir_scan(search->fd_dir, on_fd_entry, search);
+  close(search->fd_dir);
+  if (!search->is_holding) return TRUE;
+
+  gchar comm[256] = "";
+  g_autofree gchar* comm_path = g_strconcat(name, "/comm", NULL);
+  int fd = openat(search->request->proc_fd, comm_path, O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    ssize_t n = read(fd, comm, sizeof(comm) - 1);
+    comm[n > 0 ? n : 0] = '\0';
+    g_strchomp(comm);
+    close(fd);
+  }
+  g_hash_table_insert(search->holders, GINT_TO_POINTER(pid), g_strdup(comm));
+  return TRUE;
+}
+
+// Walking every process's fd table takes tens of milliseconds on a busy
+// desktop, so it stays off the main loop.
+static void holder_search_thread(GTask* task,
+                                 gpointer source_object,
+                                 gpointer task_data,
+                                 GCancellable* cancellable) {
+  const HolderRequest* request = (const HolderRequest*)task_data;
+  HolderSearch search = {request, cancellable, NULL, -1, FALSE};
+  search.holders =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+  dir_scan(request->proc_fd, on_proc_entry, &search);
+  g_task_return_pointer(task, search.holders,
+                        (GDestroyNotify)g_hash_table_unref);
+}
+
+// Takes ownership of |holders| and reports the difference to the last set.
+static void update_holders(LoopbackMonitor* self, GHashTable* holders) {
+  // Swap in the new set first so callbacks see a consistent monitor.
+  GHashTable* previous = self->holders;
+  self->holders = holders;
+
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, previous);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (!g_hash_table_contains(self->holders, key)) {
+      self->callback(GPOINTER_TO_INT(key), (const gchar*)value, FALSE,
+                     self->user_data);
+    }
+  }
+  g_hash_table_iter_init(&iter, self->holders);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (!g_hash_table_contains(previous, key)) {
+      self->callback(GPOINTER_TO_INT(key), (const gchar*)value, TRUE,
+                     self->user_data);
+    }
+  }
+  g_hash_table_unref(previous);
+}
+
+static void schedule_holder_check(LoopbackMonitor* self);
+
+static void on_holder_search_done(GObject* source,
+                                  GAsyncResult* result,
+                                  gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  GHashTable* holders =
+      (GHashTable*)g_task_propagate_pointer(G_TASK(result), &error);
+  if (holders == NULL) return;  // Cancelled — |user_data| may be gone.
+
+  LoopbackMonitor* self = (LoopbackMonitor*)user_data;
+  g_clear_object(&self->check_cancellable);
+  update_holders(self, holders);
+
+  // Opens and closes during the walk may have been missed.
+  if (self->is_recheck_needed) {
+    self->is_recheck_needed = FALSE;
+    schedule_holder_check(self);
+  }
+}
+
+static gboolean check_holders(gpointer user_data) {
+  LoopbackMonitor* self = (LoopbackMonitor*)user_data;
+  self->check_timer_id = 0;
+
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->devices);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (GPOINTER_TO_INT(value) < 0) {
+      g_hash_table_iter_replace(
+          &iter, GINT_TO_POINTER(watch_device(self, (const gchar*)key)));
+    }
+  }
+
+  if (g_hash_table_size(self->devices) == 0) {
+    // Nobody can hold a device that does not exist.
+    update_holders(self, g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                               NULL, g_free));
+    return G_SOURCE_REMOVE;
+  }
+
+  // The worker needs its own descriptor; stop() closes ours.
+  int proc_fd = fcntl(self->proc_fd, F_DUPFD_CLOEXEC, 0);
+  if (proc_fd < 0) return G_SOURCE_REMOVE;
+
+  HolderRequest* request = g_new0(HolderRequest, 1);
+  request->proc_fd = proc_fd;
+  request->devices = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                           NULL);
+  g_hash_table_iter_init(&iter, self->devices);
+  while (g_hash_table_iter_next(&iter, &key, NULL)) {
+    g_hash_table_add(request->devices, g_strdup((const gchar*)key));
+  }
+
+  self->check_cancellable = g_cancellable_new();
+  GTask* task = g_task_new(NULL, self->check_cancellable,
+                           on_holder_search_done, self);
+  g_task_set_task_data(task, request, holder_request_free);
+  g_task_run_in_thread(task, holder_search_thread);
+  g_object_unref(task);
+  return G_SOURCE_REMOVE;
+}
+
+static void schedule_holder_check(LoopbackMonitor* self) {
+  if (self->check_cancellable != NULL) {
+    self->is_recheck_needed = TRUE;  // Checked again once the walk is done.
+    return;
+  }
+  if (self->check_timer_id != 0) return;
+  self->check_timer_id =
+      g_timeout_add(HOLDER_CHECK_DELAY_MS, check_holders, self);
+}
+
+// ---------------------------------------------------------------------------
+// Events
+// ---------------------------------------------------------------------------
+
+// Handles one "ACTION@DEVPATH\0KEY=VALUE\0..." kernel uevent.
+static void handle_uevent(LoopbackMonitor* self, const gchar* buffer,
+                          gsize length) {
+  const gchar* action = NULL;
+  const gchar* devpath = NULL;
+  const gchar* subsystem = NULL;
+  const gchar* devname = NULL;
+  const gchar* end = buffer + length;
+  for (const gchar* field = buffer + strlen(buffer) + 1; field < end;
+       field += strlen(field) + 1) {
+    if (g_str_has_prefix(field, "ACTION=")) {
+      action = field + strlen("ACTION=");
+    } else if (g_str_has_prefix(field, "DEVPATH=")) {
+      devpath = field + strlen("DEVPATH=");
+    } else if (g_str_has_prefix(field, "SUBSYSTEM=")) {
+      subsystem = field + strlen("SUBSYSTEM=");
+    } else if (g_str_has_prefix(field, "DEVNAME=")) {
+      devname = field + strlen("DEVNAME=");
+    }
+  }
+  if (action == NULL || devpath == NULL || devname == NULL ||
+      g_strcmp0(subsystem, "video4linux") != 0 ||
+      !g_str_has_prefix(devpath, VIRTUAL_DEVPATH_PREFIX)) {
+    return;
+  }
+
+  g_autofree gchar* path = g_strconcat("/dev/", devname, NULL);
+  if (strcmp(action, "add") == 0) {
+    add_device(self, path);
+  } else if (strcmp(action, "remove") == 0) {
+    remove_device(self, path);
+  } else {
+    return;
+  }
+  schedule_holder_check(self);
+}
+
+static gboolean on_uevent_ready(gint fd,
+                                GIOCondition condition,
+                                gpointer user_data) {
+  LoopbackMonitor* self = (LoopbackMonitor*)user_data;
+
+  if (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+    g_warning("no_screenshot: device event socket failed");
+    self->uevent_watch_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  gchar buffer[UEVENT_BUFFER_SIZE];
+  for (;;) {
+    struct sockaddr_nl from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n = recvfrom(fd, buffer, sizeof(buffer) - 1, 0,
+                         (struct sockaddr*)&from, &from_len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == ENOBUFS) {
+        // Events were dropped; start over from sysfs.
+        enumerate_devices(self);
+        schedule_holder_check(self);
+        continue;
+      }
+      break;  // EAGAIN — drained.
+    }
+    if (from.nl_pid != 0) continue;  // Not sent by the kernel.
+    buffer[n] = '\0';
+    handle_uevent(self, buffer, (gsize)n);
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_inotify_ready(gint fd,
+                                 GIOCondition condition,
+                                 gpointer user_data) {
+  LoopbackMonitor* self = (LoopbackMonitor*)user_data;
+  char buffer[INOTIFY_BUFFER_SIZE]
+      __attribute__((aligned(__alignof__(struct inotify_event))));
+  gboolean has_events = FALSE;
+  for (;;) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;  // EAGAIN — drained.
+    has_events = TRUE;
+  }
+  if (has_events) schedule_holder_check(self);
+  return G_SOURCE_CONTINUE;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LoopbackMonitor* loopback_monitor_new(LoopbackHolderCallback cb,
+                                      gpointer user_data) {
+  LoopbackMonitor* self = g_new0(LoopbackMonitor, 1);
+  self->callback = cb;
+  self->user_data = user_data;
+  self->uevent_fd = -1;
+  self->inotify_fd = -1;
+  self->proc_fd = -1;
+  self->devices =
+      g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  self->holders =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+  return self;
+}
+
+void loopback_monitor_free(LoopbackMonitor* self) {
+  if (self == NULL) return;
+  loopback_monitor_stop(self);
+  g_hash_table_unref(self->devices);
+  g_hash_table_unref(self->holders);
+  g_free(self);
+}
+
+static int open_uevent_socket() {
+  int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  NETLINK_KOBJECT_UEVENT);
+  if (fd < 0) return -1;
+
+  struct sockaddr_nl address;
+  memset(&address, 0, sizeof(address));
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = UEVENT_GROUP_KERNEL;
+  address.nl_pid = 0;  // Let the kernel assign a port id.
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+gboolean loopback_monitor_start(LoopbackMonitor* self) {
+  if (self->proc_fd >= 0) return TRUE;  // Already started.
+
+  self->proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (self->proc_fd < 0) return FALSE;
+
+  self->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (self->inotify_fd >= 0) {
+    self->inotify_watch_id = g_unix_fd_add(self->inotify_fd, G_IO_IN,
+                                           on_inotify_ready, self);
+  }
+
+  // Subscribe before enumerating so no device added in between is missed.
+  self->uevent_fd = open_uevent_socket();
+  if (self->uevent_fd >= 0) {
+    self->uevent_watch_id = g_unix_fd_add(
+        self->uevent_fd, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP),
+        on_uevent_ready, self);
+  } else {
+    g_message("no_screenshot: device events unavailable (%s)",
+              g_strerror(errno));
+  }
+
+  enumerate_devices(self);
+  if (g_hash_table_size(self->devices) > 0) check_holders(self);
+  return self->uevent_fd >= 0;
+}
+
+void loopback_monitor_stop(LoopbackMonitor* self) {
+  if (self->check_timer_id != 0) {
+    g_source_remove(self->check_timer_id);
+    self->check_timer_id = 0;
+  }
+  if (self->check_cancellable != NULL) {
+    g_cancellable_cancel(self->check_cancellable);
+    g_clear_object(&self->check_cancellable);
+  }
+  self->is_recheck_needed = FALSE;
+  if (self->uevent_watch_id != 0) {
+    g_source_remove(self->uevent_watch_id);
+    self->uevent_watch_id = 0;
+  }
+  if (self->uevent_fd >= 0) {
+    close(self->uevent_fd);
+    self->uevent_fd = -1;
+  }
+  if (self->inotify_watch_id != 0) {
+    g_source_remove(self->inotify_watch_id);
+    self->inotify_watch_id = 0;
+  }
+  if (self->inotify_fd >= 0) {
+    close(self->inotify_fd);  // Drops all watches.
+    self->inotify_fd = -1;
+  }
+  if (self->proc_fd >= 0) {
+    close(self->proc_fd);
+    self->proc_fd = -1;
+  }
+  g_hash_table_remove_all(self->devices);
+  g_hash_table_remove_all(self->holders);
+}
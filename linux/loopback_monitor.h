@@ -0,0 +1,33 @@
+#ifndef LOOPBACK_MONITOR_H_
+#define LOOPBACK_MONITOR_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Watches v4l2loopback devices — virtual cameras such as OBS's, which
+// re-broadcast the screen — and reports the processes holding one open.
+// Devices come and go through kernel uevents, and opens and closes of the
+// device nodes through inotify; holders are only looked up after one of
+// those events, never on a timer, and on a worker thread.
+typedef struct _LoopbackMonitor LoopbackMonitor;
+
+// Invoked on the main loop when |pid| (named |app_name|) opens its first or
+// closes its last loopback device.
+typedef void (*LoopbackHolderCallback)(gint pid,
+                                       const gchar* app_name,
+                                       gboolean is_holding,
+                                       gpointer user_data);
+
+LoopbackMonitor* loopback_monitor_new(LoopbackHolderCallback cb,
+                                      gpointer user_data);
+void loopback_monitor_free(LoopbackMonitor* self);
+
+// Returns FALSE if device events are unavailable; devices present at start
+// are still watched.
+gboolean loopback_monitor_start(LoopbackMonitor* self);
+void loopback_monitor_stop(LoopbackMonitor* self);
+
+G_END_DECLS
+
+#endif  // LOOPBACK_MONITOR_H_
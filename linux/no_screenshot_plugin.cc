@@ -22,33 +22,85 @@ G_DEFINE_TYPE(NoScreenshotPlugin, no_screenshot_plugin, g_object_get_type())
 // Helpers
 // ---------------------------------------------------------------------------
 
+static void append_json_string(GString* json, const gchar* value) {
+  g_string_append_c(json, '"');
+  for (const gchar* p = value ? value : ""; *p != '\0'; p++) {
+    switch (*p) {
+      case '"':
+        g_string_append(json, "\\\"");
+        break;
+      case '\\':
+        g_string_append(json, "\\\\");
+        break;
+      default:
+        if ((guchar)*p < 0x20) {
+          g_string_append_printf(json, "\\u%04x", (guchar)*p);
+        } else {
+          g_string_append_c(json, *p);
+        }
+    }
+  }
+  g_string_append_c(json, '"');
+}
+
 gchar* build_event_json(gboolean is_screenshot_on,
                         const gchar* screenshot_path,
                         gboolean was_screenshot_taken,
                         gboolean is_screen_recording,
                         gint64 timestamp_ms,
-                        const gchar* source_app) {
+                        const gchar* source_app,
+                        const ScreenshotBurst* burst,
+                        const gchar* const* active_recorders) {
   // Hand-build JSON to avoid extra dependencies.
-  return g_strdup_printf(
-      "{\"is_screenshot_on\":%s,\"screenshot_path\":\"%s\","
-      "\"was_screenshot_taken\":%s,\"is_screen_recording\":%s,"
-      "\"timestamp\":%" G_GINT64_FORMAT ",\"source_app\":\"%s\"}",
-      is_screenshot_on ? "true" : "false",
-      screenshot_path ? screenshot_path : "",
+  GString* json = g_string_new("{\"is_screenshot_on\":");
+  g_string_append(json, is_screenshot_on ? "true" : "false");
+  g_string_append(json, ",\"screenshot_path\":");
+  append_json_string(json, screenshot_path);
+  g_string_append_printf(
+      json,
+      ",\"was_screenshot_taken\":%s,\"is_screen_recording\":%s,"
+      "\"timestamp\":%" G_GINT64_FORMAT ",\"source_app\":",
       was_screenshot_taken ? "true" : "false",
-      is_screen_recording ? "true" : "false",
-      timestamp_ms,
-      source_app ? source_app : "");
+      is_screen_recording ? "true" : "false", timestamp_ms);
+  append_json_string(json, source_app);
+
+  if (burst != NULL) {
+    g_string_append_printf(
+        json,
+        ",\"burst_count\":%d,\"burst_first_timestamp\":%" G_GINT64_FORMAT
+        ",\"burst_last_timestamp\":%" G_GINT64_FORMAT
+        ",\"is_burst_closed\":%s,\"burst_paths\":[",
+        burst->count, burst->first_timestamp_ms, burst->last_timestamp_ms,
+        burst->is_closed ? "true" : "false");
+    for (gint i = 0; i < burst->n_paths; i++) {
+      if (i > 0) g_string_append_c(json, ',');
+      append_json_string(json, burst->paths[i]);
+    }
+    g_string_append_c(json, ']');
+  }
+
+  g_string_append(json, ",\"active_recorders\":[");
+  for (gint i = 0; active_recorders != NULL && active_recorders[i] != NULL;
+       i++) {
+    if (i > 0) g_string_append_c(json, ',');
+    append_json_string(json, active_recorders[i]);
+  }
+  g_string_append_c(json, ']');
+
+  g_string_append_c(json, '}');
+  return g_string_free(json, FALSE);
 }
 
-static void update_shared_state(NoScreenshotPlugin* self,
-                                const gchar* screenshot_path) {
+static void update_shared_state_with_burst(NoScreenshotPlugin* self,
+                                           const gchar* screenshot_path,
+                                           const ScreenshotBurst* burst) {
   gboolean was_taken = (screenshot_path != NULL && screenshot_path[0] != '\0');
 
   g_autofree gchar* json =
       build_event_json(self->prevent_screenshot, screenshot_path, was_taken,
                        self->is_screen_recording, self->last_timestamp_ms,
-                       self->last_source_app);
+                       self->last_source_app, burst,
+                       self->active_recorders);
 
   if (g_strcmp0(json, self->last_event_json) != 0) {
     g_free(self->last_event_json);
@@ -57,16 +109,129 @@ static void update_shared_state(NoScreenshotPlugin* self,
   }
 }
 
-static void persist_state(NoScreenshotPlugin* self) {
-  state_persistence_save(self->persistence, self->prevent_screenshot,
-                         self->is_image_overlay_mode,
-                         self->is_blur_overlay_mode,
-                         self->is_color_overlay_mode,
-                         self->blur_radius,
-                         self->color_value);
+static void update_shared_state(NoScreenshotPlugin* self,
+                                const gchar* screenshot_path) {
+  update_shared_state_with_burst(self, screenshot_path, NULL);
+}
+
+// Saves the |fields| (a PersistedField mask) the caller changed. Before the
+// state has loaded, the others are still defaults that must not overwrite it.
+static void save_state(NoScreenshotPlugin* self, guint fields) {
+  PersistedState state = {
+      self->prevent_screenshot,   self->is_image_overlay_mode,
+      self->is_blur_overlay_mode, self->is_color_overlay_mode,
+      self->blur_radius,          self->color_value,
+      self->screenshot_cursor_ms,
+  };
+  state_persistence_save(self->persistence, &state, fields);
+}
+
+// Recording detection polls fastest while protected content is on screen
+// and in front of the user.
+static void update_recording_attention(NoScreenshotPlugin* self) {
+  if (self->recording_detection == NULL) return;
+  gboolean is_attentive =
+      self->prevent_screenshot &&
+      (self->window == NULL ||
+       (self->is_window_visible && gtk_window_is_active(self->window)));
+  recording_detection_set_attentive(self->recording_detection, is_attentive);
+}
+
+static void persist_state(NoScreenshotPlugin* self, guint fields) {
+  save_state(self, fields);
+  update_recording_attention(self);
   update_shared_state(self, "");
 }
 
+// ---------------------------------------------------------------------------
+// Window attention
+// ---------------------------------------------------------------------------
+
+static void on_window_active_changed(GObject* window,
+                                     GParamSpec* pspec,
+                                     gpointer user_data) {
+  update_recording_attention(NO_SCREENSHOT_PLUGIN(user_data));
+}
+
+static gboolean on_window_state_changed(GtkWidget* window,
+                                        GdkEventWindowState* event,
+                                        gpointer user_data) {
+  NoScreenshotPlugin* self = NO_SCREENSHOT_PLUGIN(user_data);
+  self->is_window_visible =
+      (event->new_window_state &
+       (GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN)) == 0;
+  update_recording_attention(self);
+  return FALSE;
+}
+
+static void watch_window(NoScreenshotPlugin* self,
+                         FlPluginRegistrar* registrar) {
+  FlView* view = fl_plugin_registrar_get_view(registrar);
+  if (view == NULL) return;
+  GtkWidget* toplevel = gtk_widget_get_toplevel(GTK_WIDGET(view));
+  if (!GTK_IS_WINDOW(toplevel)) return;
+
+  self->window = GTK_WINDOW(toplevel);
+  self->is_window_visible = gtk_widget_get_visible(toplevel);
+  g_object_add_weak_pointer(G_OBJECT(self->window),
+                            (gpointer*)&self->window);
+  g_signal_connect_object(self->window, "notify::is-active",
+                          G_CALLBACK(on_window_active_changed), self,
+                          (GConnectFlags)0);
+  g_signal_connect_object(self->window, "window-state-event",
+                          G_CALLBACK(on_window_state_changed), self,
+                          (GConnectFlags)0);
+}
+
+// ---------------------------------------------------------------------------
+// Screen geometry
+// ---------------------------------------------------------------------------
+
+// X11 grabbers allocate one 32-bit frame per capture: of the whole screen
+// (all monitors' bounding box) or of a single monitor.
+static void update_frame_sizes(NoScreenshotPlugin* self) {
+  GdkDisplay* display = gdk_display_get_default();
+  if (display == NULL) return;
+
+  int n_monitors = gdk_display_get_n_monitors(display);
+  g_autofree guint64* sizes = g_new0(guint64, n_monitors + 1);
+  guint n_sizes = 0;
+  GdkRectangle bounds = {0, 0, 0, 0};
+  int scale = 1;
+  for (int i = 0; i < n_monitors; i++) {
+    GdkMonitor* monitor = gdk_display_get_monitor(display, i);
+    GdkRectangle geometry;
+    gdk_monitor_get_geometry(monitor, &geometry);
+    scale = gdk_monitor_get_scale_factor(monitor);
+    sizes[n_sizes++] = (guint64)(geometry.width * scale) *
+                       (guint64)(geometry.height * scale) * 4;
+    if (i == 0) {
+      bounds = geometry;
+    } else {
+      gdk_rectangle_union(&bounds, &geometry, &bounds);
+    }
+  }
+  if (n_monitors > 1) {
+    sizes[n_sizes++] = (guint64)(bounds.width * scale) *
+                       (guint64)(bounds.height * scale) * 4;
+  }
+  recording_detection_set_frame_sizes(self->recording_detection, sizes,
+                                      n_sizes);
+}
+
+static void on_monitors_changed(GdkScreen* screen, gpointer user_data) {
+  update_frame_sizes(NO_SCREENSHOT_PLUGIN(user_data));
+}
+
+static void watch_screen(NoScreenshotPlugin* self) {
+  GdkScreen* screen = gdk_screen_get_default();
+  if (screen == NULL) return;
+  g_signal_connect_object(screen, "monitors-changed",
+                          G_CALLBACK(on_monitors_changed), self,
+                          (GConnectFlags)0);
+  update_frame_sizes(self);
+}
+
 // ---------------------------------------------------------------------------
 // Screenshot detection callback
 // ---------------------------------------------------------------------------
@@ -74,12 +239,20 @@ static void persist_state(NoScreenshotPlugin* self) {
 static void on_screenshot_detected(const gchar* file_path,
                                    gint64 timestamp_ms,
                                    const gchar* source_app,
+                                   const ScreenshotBurst* burst,
                                    gpointer user_data) {
   NoScreenshotPlugin* self = NO_SCREENSHOT_PLUGIN(user_data);
   self->last_timestamp_ms = timestamp_ms;
   g_free(self->last_source_app);
   self->last_source_app = g_strdup(source_app ? source_app : "");
-  update_shared_state(self, file_path);
+  update_shared_state_with_burst(self, file_path, burst);
+
+  // Keep the catch-up cursor current in case the process is killed.
+  gint64 cursor_ms = screenshot_detection_get_cursor(self->detection);
+  if (cursor_ms != self->screenshot_cursor_ms) {
+    self->screenshot_cursor_ms = cursor_ms;
+    save_state(self, PERSISTED_SCREENSHOT_CURSOR);
+  }
 }
 
 // ---------------------------------------------------------------------------
@@ -91,12 +264,57 @@ static void on_recording_state_changed(gboolean is_recording,
                                        gpointer user_data) {
   NoScreenshotPlugin* self = NO_SCREENSHOT_PLUGIN(user_data);
   self->is_screen_recording = is_recording;
+
+  GPtrArray* recorders =
+      recording_detection_get_recorders(self->recording_detection);
+  g_strfreev(self->active_recorders);
+  self->active_recorders = g_new0(gchar*, recorders->len + 1);
+  for (guint i = 0; i < recorders->len; i++) {
+    const ActiveRecorder* recorder =
+        (const ActiveRecorder*)g_ptr_array_index(recorders, i);
+    self->active_recorders[i] = g_strdup(recorder->name);
+  }
+  g_ptr_array_unref(recorders);
+
   self->last_timestamp_ms = g_get_real_time() / 1000;
   g_free(self->last_source_app);
   self->last_source_app = g_strdup(process_name ? process_name : "");
   update_shared_state(self, "");
 }
 
+// ---------------------------------------------------------------------------
+// Subsystems
+// ---------------------------------------------------------------------------
+
+// Starts screenshot detection from the saved cursor, so it needs the state
+// to be loaded.
+static void start_screenshot_detection(NoScreenshotPlugin* self) {
+  if (self->detection == NULL) {
+    self->detection = screenshot_detection_new(on_screenshot_detected, self);
+    screenshot_detection_set_burst_gap(self->detection, self->burst_gap_ms);
+  }
+  screenshot_detection_set_cursor(self->detection, self->screenshot_cursor_ms);
+  screenshot_detection_start(self->detection);
+}
+
+static void ensure_recording_detection(NoScreenshotPlugin* self) {
+  if (self->recording_detection != NULL) return;
+  self->recording_detection =
+      recording_detection_new(on_recording_state_changed, self);
+  if (self->has_recording_config) {
+    recording_detection_set_poll_config(self->recording_detection,
+                                        &self->recording_config);
+  }
+  if (self->is_deep_scan_enabled) {
+    recording_detection_set_deep_scan(self->recording_detection, TRUE);
+  }
+  if (self->is_session_only) {
+    recording_detection_set_session_scope(self->recording_detection, TRUE);
+  }
+  watch_screen(self);
+  update_recording_attention(self);
+}
+
 // ---------------------------------------------------------------------------
 // Method channel handler
 // ---------------------------------------------------------------------------
@@ -112,14 +330,14 @@ static void handle_method_call(FlMethodChannel* channel,
   if (g_strcmp0(method, "screenshotOff") == 0) {
     self->prevent_screenshot = TRUE;
     prevention_activate();
-    persist_state(self);
+    persist_state(self, PERSISTED_PREVENT_SCREENSHOT);
     response = FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_bool(TRUE)));
 
   } else if (g_strcmp0(method, "screenshotOn") == 0) {
     self->prevent_screenshot = FALSE;
     prevention_deactivate();
-    persist_state(self);
+    persist_state(self, PERSISTED_PREVENT_SCREENSHOT);
     response = FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_bool(TRUE)));
 
@@ -131,7 +349,7 @@ static void handle_method_call(FlMethodChannel* channel,
       self->prevent_screenshot = TRUE;
       prevention_activate();
     }
-    persist_state(self);
+    persist_state(self, PERSISTED_PREVENT_SCREENSHOT);
     response = FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_bool(TRUE)));
 
@@ -156,17 +374,20 @@ static void handle_method_call(FlMethodChannel* channel,
         "best-effort on Linux — compositors control task switcher "
         "thumbnails).",
         self->is_image_overlay_mode ? "ON" : "OFF");
-    persist_state(self);
+    persist_state(self,
+                  PERSISTED_PREVENT_SCREENSHOT | PERSISTED_OVERLAY_MODES);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(
         fl_value_new_bool(self->is_image_overlay_mode)));
 
   } else if (g_strcmp0(method, "toggleScreenshotWithBlur") == 0) {
+    guint fields = PERSISTED_PREVENT_SCREENSHOT | PERSISTED_OVERLAY_MODES;
     FlValue* args = fl_method_call_get_args(method_call);
     if (args != NULL && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
       FlValue* radius_val = fl_value_lookup_string(args, "radius");
       if (radius_val != NULL &&
           fl_value_get_type(radius_val) == FL_VALUE_TYPE_FLOAT) {
         self->blur_radius = fl_value_get_float(radius_val);
+        fields |= PERSISTED_BLUR_RADIUS;
       }
     }
     self->is_blur_overlay_mode = !self->is_blur_overlay_mode;
@@ -189,17 +410,19 @@ static void handle_method_call(FlMethodChannel* channel,
         "best-effort on Linux — compositors control task switcher "
         "thumbnails).",
         self->is_blur_overlay_mode ? "ON" : "OFF", self->blur_radius);
-    persist_state(self);
+    persist_state(self, fields);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(
         fl_value_new_bool(self->is_blur_overlay_mode)));
 
   } else if (g_strcmp0(method, "toggleScreenshotWithColor") == 0) {
+    guint fields = PERSISTED_PREVENT_SCREENSHOT | PERSISTED_OVERLAY_MODES;
     FlValue* args = fl_method_call_get_args(method_call);
     if (args != NULL && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
       FlValue* color_val = fl_value_lookup_string(args, "color");
       if (color_val != NULL &&
           fl_value_get_type(color_val) == FL_VALUE_TYPE_INT) {
         self->color_value = (gint)fl_value_get_int(color_val);
+        fields |= PERSISTED_COLOR_VALUE;
       }
     }
     self->is_color_overlay_mode = !self->is_color_overlay_mode;
@@ -222,7 +445,7 @@ static void handle_method_call(FlMethodChannel* channel,
         "color overlay is best-effort on Linux — compositors control task "
         "switcher thumbnails).",
         self->is_color_overlay_mode ? "ON" : "OFF", self->color_value);
-    persist_state(self);
+    persist_state(self, fields);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(
         fl_value_new_bool(self->is_color_overlay_mode)));
 
@@ -236,17 +459,20 @@ static void handle_method_call(FlMethodChannel* channel,
     }
     self->prevent_screenshot = TRUE;
     prevention_activate();
-    persist_state(self);
+    persist_state(self,
+                  PERSISTED_PREVENT_SCREENSHOT | PERSISTED_OVERLAY_MODES);
     response = FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_bool(TRUE)));
 
   } else if (g_strcmp0(method, "screenshotWithBlur") == 0) {
+    guint fields = PERSISTED_PREVENT_SCREENSHOT | PERSISTED_OVERLAY_MODES;
     FlValue* args = fl_method_call_get_args(method_call);
     if (args != NULL && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
       FlValue* radius_val = fl_value_lookup_string(args, "radius");
       if (radius_val != NULL &&
           fl_value_get_type(radius_val) == FL_VALUE_TYPE_FLOAT) {
         self->blur_radius = fl_value_get_float(radius_val);
+        fields |= PERSISTED_BLUR_RADIUS;
       }
     }
     self->is_blur_overlay_mode = TRUE;
@@ -258,17 +484,19 @@ static void handle_method_call(FlMethodChannel* channel,
     }
     self->prevent_screenshot = TRUE;
     prevention_activate();
-    persist_state(self);
+    persist_state(self, fields);
     response = FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_bool(TRUE)));
 
   } else if (g_strcmp0(method, "screenshotWithColor") == 0) {
+    guint fields = PERSISTED_PREVENT_SCREENSHOT | PERSISTED_OVERLAY_MODES;
     FlValue* args = fl_method_call_get_args(method_call);
     if (args != NULL && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
       FlValue* color_val = fl_value_lookup_string(args, "color");
       if (color_val != NULL &&
           fl_value_get_type(color_val) == FL_VALUE_TYPE_INT) {
         self->color_value = (gint)fl_value_get_int(color_val);
+        fields |= PERSISTED_COLOR_VALUE;
       }
     }
     self->is_color_overlay_mode = TRUE;
@@ -280,15 +508,16 @@ static void handle_method_call(FlMethodChannel* channel,
     }
     self->prevent_screenshot = TRUE;
     prevention_activate();
-    persist_state(self);
+    persist_state(self, fields);
     response = FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_bool(TRUE)));
 
   } else if (g_strcmp0(method, "startScreenshotListening") == 0) {
     if (!self->is_listening) {
       self->is_listening = TRUE;
-      screenshot_detection_start(self->detection);
-      persist_state(self);
+      // Otherwise it starts once the saved cursor is known.
+      if (self->is_state_loaded) start_screenshot_detection(self);
+      update_shared_state(self, "");
     }
     g_autoptr(FlValue) msg = fl_value_new_string("Listening started");
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(msg));
@@ -296,26 +525,96 @@ static void handle_method_call(FlMethodChannel* channel,
   } else if (g_strcmp0(method, "stopScreenshotListening") == 0) {
     if (self->is_listening) {
       self->is_listening = FALSE;
-      screenshot_detection_stop(self->detection);
-      persist_state(self);
+      if (self->detection != NULL) {
+        screenshot_detection_stop(self->detection);
+        self->screenshot_cursor_ms =
+            screenshot_detection_get_cursor(self->detection);
+        save_state(self, PERSISTED_SCREENSHOT_CURSOR);
+      }
+      update_shared_state(self, "");
     }
     g_autoptr(FlValue) msg = fl_value_new_string("Listening stopped");
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(msg));
 
+  } else if (g_strcmp0(method, "configureScreenshotDetection") == 0) {
+    FlValue* args = fl_method_call_get_args(method_call);
+    if (args != NULL && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+      FlValue* gap_val = fl_value_lookup_string(args, "burst_gap_ms");
+      if (gap_val != NULL && fl_value_get_type(gap_val) == FL_VALUE_TYPE_INT) {
+        self->burst_gap_ms = (guint)CLAMP(fl_value_get_int(gap_val), 0,
+                                          G_MAXINT);
+      }
+    }
+    if (self->detection != NULL) {
+      screenshot_detection_set_burst_gap(self->detection, self->burst_gap_ms);
+    }
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+
   } else if (g_strcmp0(method, "startScreenRecordingListening") == 0) {
     if (!self->is_recording_listening) {
       self->is_recording_listening = TRUE;
+      ensure_recording_detection(self);
       recording_detection_start(self->recording_detection);
       update_shared_state(self, "");
     }
     g_autoptr(FlValue) msg = fl_value_new_string("Recording listening started");
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(msg));
 
+  } else if (g_strcmp0(method, "configureScreenRecordingDetection") == 0) {
+    PollSchedulerConfig config = {
+        POLL_SCHEDULER_DEFAULT_MIN_INTERVAL_MS,
+        POLL_SCHEDULER_DEFAULT_MAX_INTERVAL_MS,
+        POLL_SCHEDULER_DEFAULT_CPU_BUDGET,
+    };
+    FlValue* args = fl_method_call_get_args(method_call);
+    if (args != NULL && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+      FlValue* min_val = fl_value_lookup_string(args, "min_interval_ms");
+      if (min_val != NULL && fl_value_get_type(min_val) == FL_VALUE_TYPE_INT) {
+        config.min_interval_ms = (guint)CLAMP(fl_value_get_int(min_val), 1,
+                                              G_MAXINT);
+      }
+      FlValue* max_val = fl_value_lookup_string(args, "max_interval_ms");
+      if (max_val != NULL && fl_value_get_type(max_val) == FL_VALUE_TYPE_INT) {
+        config.max_interval_ms = (guint)CLAMP(fl_value_get_int(max_val), 1,
+                                              G_MAXINT);
+      }
+      FlValue* budget_val = fl_value_lookup_string(args, "cpu_budget");
+      if (budget_val != NULL &&
+          fl_value_get_type(budget_val) == FL_VALUE_TYPE_FLOAT) {
+        config.cpu_budget = fl_value_get_float(budget_val);
+      }
+      FlValue* deep_val = fl_value_lookup_string(args, "deep_scan");
+      if (deep_val != NULL &&
+          fl_value_get_type(deep_val) == FL_VALUE_TYPE_BOOL) {
+        self->is_deep_scan_enabled = fl_value_get_bool(deep_val);
+        if (self->recording_detection != NULL) {
+          recording_detection_set_deep_scan(self->recording_detection,
+                                            self->is_deep_scan_enabled);
+        }
+      }
+      FlValue* session_val = fl_value_lookup_string(args, "session_only");
+      if (session_val != NULL &&
+          fl_value_get_type(session_val) == FL_VALUE_TYPE_BOOL) {
+        self->is_session_only = fl_value_get_bool(session_val);
+        if (self->recording_detection != NULL) {
+          recording_detection_set_session_scope(self->recording_detection,
+                                                self->is_session_only);
+        }
+      }
+    }
+    self->recording_config = config;
+    self->has_recording_config = TRUE;
+    if (self->recording_detection != NULL) {
+      recording_detection_set_poll_config(self->recording_detection, &config);
+    }
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+
   } else if (g_strcmp0(method, "stopScreenRecordingListening") == 0) {
     if (self->is_recording_listening) {
       self->is_recording_listening = FALSE;
       recording_detection_stop(self->recording_detection);
       self->is_screen_recording = FALSE;
+      g_clear_pointer(&self->active_recorders, g_strfreev);
       update_shared_state(self, "");
     }
     g_autoptr(FlValue) msg =
@@ -385,9 +684,29 @@ static void no_screenshot_plugin_dispose(GObject* object) {
     self->stream_timer_id = 0;
   }
 
+  if (self->window != NULL) {
+    g_signal_handlers_disconnect_by_data(self->window, self);
+    g_object_remove_weak_pointer(G_OBJECT(self->window),
+                                 (gpointer*)&self->window);
+    self->window = NULL;
+  }
+
+  GdkScreen* screen = gdk_screen_get_default();
+  if (screen != NULL) g_signal_handlers_disconnect_by_data(screen, self);
+
   g_clear_object(&self->method_channel);
   g_clear_object(&self->event_channel);
 
+  // Record how far screenshots were seen so the next launch catches up
+  // from here.
+  if (self->is_listening && self->detection != NULL &&
+      self->persistence != NULL) {
+    screenshot_detection_stop(self->detection);
+    self->screenshot_cursor_ms =
+        screenshot_detection_get_cursor(self->detection);
+    save_state(self, PERSISTED_SCREENSHOT_CURSOR);
+  }
+
   screenshot_detection_free(self->detection);
   self->detection = NULL;
 
@@ -403,6 +722,8 @@ static void no_screenshot_plugin_dispose(GObject* object) {
   g_free(self->last_source_app);
   self->last_source_app = NULL;
 
+  g_clear_pointer(&self->active_recorders, g_strfreev);
+
   G_OBJECT_CLASS(no_screenshot_plugin_parent_class)->dispose(object);
 }
 
@@ -418,8 +739,18 @@ static void no_screenshot_plugin_init(NoScreenshotPlugin* self) {
   self->blur_radius = 30.0;
   self->color_value = (gint)0xFF000000;
   self->is_listening = FALSE;
+  self->burst_gap_ms = 0;
+  self->screenshot_cursor_ms = 0;
+  self->is_state_loaded = FALSE;
+  self->registered_us = 0;
   self->is_recording_listening = FALSE;
   self->is_screen_recording = FALSE;
+  self->active_recorders = NULL;
+  self->has_recording_config = FALSE;
+  self->is_deep_scan_enabled = FALSE;
+  self->is_session_only = FALSE;
+  self->window = NULL;
+  self->is_window_visible = FALSE;
   self->last_event_json = NULL;
   self->has_pending_event = FALSE;
   self->stream_timer_id = 0;
@@ -435,32 +766,57 @@ static void no_screenshot_plugin_init(NoScreenshotPlugin* self) {
 // Plugin registration
 // ---------------------------------------------------------------------------
 
+static const gchar* get_app_id() {
+  GApplication* app = g_application_get_default();
+  const gchar* app_id =
+      app != NULL ? g_application_get_application_id(app) : NULL;
+  return app_id != NULL ? app_id : g_get_prgname();
+}
+
+static void on_state_loaded(const PersistedState* state, gpointer user_data) {
+  NoScreenshotPlugin* self = NO_SCREENSHOT_PLUGIN(user_data);
+  self->is_state_loaded = TRUE;
+  self->screenshot_cursor_ms = state->screenshot_cursor_ms;
+  g_message("no_screenshot: state loaded %" G_GINT64_FORMAT
+            " us after registration",
+            g_get_monotonic_time() - self->registered_us);
+
+  // Fields the app set before the load are already in |state|.
+  gboolean was_preventing = self->prevent_screenshot;
+  self->prevent_screenshot = state->prevent_screenshot;
+  self->is_image_overlay_mode = state->is_image_overlay_mode;
+  self->is_blur_overlay_mode = state->is_blur_overlay_mode;
+  self->is_color_overlay_mode = state->is_color_overlay_mode;
+  self->blur_radius = state->blur_radius;
+  self->color_value = state->color_value;
+  if (self->prevent_screenshot && !was_preventing) {
+    prevention_activate();
+  }
+  update_recording_attention(self);
+  update_shared_state(self, "");
+
+  if (self->is_listening) start_screenshot_detection(self);
+}
+
+// Registration runs before the app's first frame, so it does no I/O: the
+// saved state is loaded on a worker thread, and the detectors are created
+// when listening first starts.
 void no_screenshot_plugin_register_with_registrar(
     FlPluginRegistrar* registrar) {
   NoScreenshotPlugin* self = NO_SCREENSHOT_PLUGIN(
       g_object_new(no_screenshot_plugin_get_type(), NULL));
 
   self->registrar = registrar;
+  self->registered_us = g_get_monotonic_time();
 
-  // Subsystems
-  self->persistence = state_persistence_new();
-  self->detection =
-      screenshot_detection_new(on_screenshot_detected, self);
-  self->recording_detection =
-      recording_detection_new(on_recording_state_changed, self);
-
-  // Load persisted state
-  PersistedState state = state_persistence_load(self->persistence);
-  self->prevent_screenshot = state.prevent_screenshot;
-  self->is_image_overlay_mode = state.is_image_overlay_mode;
-  self->is_blur_overlay_mode = state.is_blur_overlay_mode;
-  self->is_color_overlay_mode = state.is_color_overlay_mode;
-  self->blur_radius = state.blur_radius;
-  self->color_value = state.color_value;
+  watch_window(self, registrar);
 
-  if (self->prevent_screenshot) {
-    prevention_activate();
-  }
+  // The window's role, if the app set one, tells its saved state apart from
+  // that of its other windows.
+  self->persistence = state_persistence_new(
+      get_app_id(),
+      self->window != NULL ? gtk_window_get_role(self->window) : NULL);
+  state_persistence_load_async(self->persistence, on_state_loaded, self);
 
   // Method channel
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
@@ -484,5 +840,7 @@ void no_screenshot_plugin_register_with_registrar(
   // Initial state push
   update_shared_state(self, "");
 
+  g_message("no_screenshot: registered in %" G_GINT64_FORMAT " us",
+            g_get_monotonic_time() - self->registered_us);
   g_object_unref(self);
 }
@@ -34,6 +34,12 @@ struct _NoScreenshotPlugin {
   gdouble blur_radius;
   gint color_value;
   gboolean is_listening;
+  guint burst_gap_ms;  // 0 for the detector's default.
+  gint64 screenshot_cursor_ms;  // Screenshots up to here have been reported.
+  // The saved state arrives asynchronously after registration. Fields the
+  // app sets before then win over it.
+  gboolean is_state_loaded;
+  gint64 registered_us;  // Monotonic time registration began.
 
   // Event stream
   gchar* last_event_json;
@@ -44,24 +50,39 @@ struct _NoScreenshotPlugin {
   // Recording detection
   gboolean is_recording_listening;
   gboolean is_screen_recording;
+  gchar** active_recorders;  // Names, oldest first; NULL when none.
+  // Configuration received before the detector was created.
+  PollSchedulerConfig recording_config;
+  gboolean has_recording_config;
+  gboolean is_deep_scan_enabled;
+  gboolean is_session_only;
+
+  // The app window, watched so recording detection polls fastest while the
+  // user looks at protected content. NULL when headless.
+  GtkWindow* window;
+  gboolean is_window_visible;
 
   // P8 metadata
   gint64 last_timestamp_ms;
   gchar* last_source_app;
 
-  // Subsystems
+  // Subsystems. The detectors are created when listening first starts.
   ScreenshotDetection* detection;
   RecordingDetection* recording_detection;
   StatePersistence* persistence;
 };
 
 // Build a JSON string matching the Dart ScreenshotSnapshot format.
+// |burst| may be NULL for events that are not screenshot captures, and
+// |active_recorders| (a NULL-terminated list) NULL when none are running.
 gchar* build_event_json(gboolean is_screenshot_on,
                         const gchar* screenshot_path,
                         gboolean was_screenshot_taken,
                         gboolean is_screen_recording,
                         gint64 timestamp_ms,
-                        const gchar* source_app);
+                        const gchar* source_app,
+                        const ScreenshotBurst* burst,
+                        const gchar* const* active_recorders);
 
 G_END_DECLS
 
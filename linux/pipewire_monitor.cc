@@ -0,0 +1,434 @@
+#include "pipewire_monitor.h"
+
+#include <glib-unix.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+#include <pipewire/pipewire.h>
+#endif
+
+// The consumer side of a video capture, e.g. a browser sharing the screen.
+#define CAPTURE_MEDIA_CLASS "Stream/Input/Video"
+// Video producers. Screencasts use either class, but so do cameras, virtual
+// cameras and apps sharing their own rendering, so the class alone does not
+// make a screen source.
+#define STREAM_SOURCE_MEDIA_CLASS "Stream/Output/Video"
+#define DEVICE_SOURCE_MEDIA_CLASS "Video/Source"
+#define SCREEN_MEDIA_ROLE "Screen"
+// After the daemon goes away, e.g. on a restart, reconnection attempts back
+// off from the minimum to the maximum delay.
+#define RECONNECT_MIN_DELAY_MS 1000
+#define RECONNECT_MAX_DELAY_MS 60000
+
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+
+// Compositors and xdg-desktop-portal backends that publish screencasts.
+static const gchar* const kScreencastProducers[] = {
+    "gnome-shell",  // Mutter
+    "kwin_wayland",
+    "xdg-desktop-portal-wlr",
+    "xdg-desktop-portal-hyprland",
+    "xdg-desktop-portal-cosmic",
+};
+
+// Names those screencast nodes get, for producers whose binary is not
+// reported.
+static const gchar* const kScreencastNodePrefixes[] = {
+    "meta-screen-cast-src",  // Mutter
+    "xdpw_stream",           // xdg-desktop-portal-wlr
+    "xdph-streaming",        // xdg-desktop-portal-hyprland
+};
+
+typedef enum {
+  NODE_OTHER,
+  NODE_CAPTURE,
+  NODE_SCREEN,
+} NodeKind;
+
+typedef struct {
+  NodeKind kind;
+  gchar* app_name;
+  gint pid;
+  gboolean is_reported;  // Captures only: reported as active.
+} Node;
+
+typedef struct {
+  guint32 output_node;
+  guint32 input_node;
+} Link;
+
+#endif  // NO_SCREENSHOT_HAVE_PIPEWIRE
+
+struct _PipeWireMonitor {
+  PipeWireCaptureCallback callback;
+  gpointer user_data;
+
+  gchar* remote_name;
+
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+  // The PipeWire loop is driven from the GLib main loop through its fd.
+  pw_loop* loop;
+  pw_context* context;
+  pw_core* core;
+  pw_registry* registry;
+  spa_hook core_listener;
+  spa_hook registry_listener;
+  guint loop_watch_id;
+  gboolean is_disconnected;
+  guint reconnect_id;
+  guint reconnect_delay_ms;
+
+  // Registry globals of interest (id → Node* / Link*).
+  GHashTable* nodes;
+  GHashTable* links;
+#endif
+};
+
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+
+static void node_free(gpointer data) {
+  Node* node = (Node*)data;
+  g_free(node->app_name);
+  g_free(node);
+}
+
+static const gchar* lookup_prop(const spa_dict* props, const gchar* key) {
+  return props != NULL ? spa_dict_lookup(props, key) : NULL;
+}
+
+static gboolean is_screencast_source(const spa_dict* props) {
+  const gchar* media_class = lookup_prop(props, PW_KEY_MEDIA_CLASS);
+  if (g_strcmp0(media_class, STREAM_SOURCE_MEDIA_CLASS) != 0 &&
+      g_strcmp0(media_class, DEVICE_SOURCE_MEDIA_CLASS) != 0) {
+    return FALSE;
+  }
+  if (g_strcmp0(lookup_prop(props, PW_KEY_MEDIA_ROLE), SCREEN_MEDIA_ROLE) ==
+      0) {
+    return TRUE;
+  }
+
+  const gchar* binary = lookup_prop(props, PW_KEY_APP_PROCESS_BINARY);
+  for (gsize i = 0; binary != NULL && i < G_N_ELEMENTS(kScreencastProducers);
+       i++) {
+    if (strcmp(binary, kScreencastProducers[i]) == 0) return TRUE;
+  }
+  const gchar* node_name = lookup_prop(props, PW_KEY_NODE_NAME);
+  for (gsize i = 0;
+       node_name != NULL && i < G_N_ELEMENTS(kScreencastNodePrefixes); i++) {
+    if (g_str_has_prefix(node_name, kScreencastNodePrefixes[i])) return TRUE;
+  }
+  return FALSE;
+}
+
+// Re-evaluates whether capture node |id| receives a screen and reports a
+// change.
+static void update_capture(PipeWireMonitor* self, guint32 id) {
+  Node* capture = (Node*)g_hash_table_lookup(self->nodes, GUINT_TO_POINTER(id));
+  if (capture == NULL || capture->kind != NODE_CAPTURE) return;
+
+  gboolean is_active = FALSE;
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->links);
+  while (!is_active && g_hash_table_iter_next(&iter, NULL, &value)) {
+    const Link* link = (const Link*)value;
+    if (link->input_node != id) continue;
+    const Node* source = (const Node*)g_hash_table_lookup(
+        self->nodes, GUINT_TO_POINTER(link->output_node));
+    is_active = source != NULL && source->kind == NODE_SCREEN;
+  }
+
+  if (is_active == capture->is_reported) return;
+  capture->is_reported = is_active;
+  if (self->callback != NULL) {
+    self->callback(id, capture->app_name, capture->pid, is_active,
+                   self->user_data);
+  }
+}
+
+// Re-evaluates the captures fed by node |id|.
+static void update_captures_of_source(PipeWireMonitor* self, guint32 id) {
+  GPtrArray* inputs = g_ptr_array_new();
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->links);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    const Link* link = (const Link*)value;
+    if (link->output_node == id) {
+      g_ptr_array_add(inputs, GUINT_TO_POINTER(link->input_node));
+    }
+  }
+  for (guint i = 0; i < inputs->len; i++) {
+    update_capture(self, GPOINTER_TO_UINT(g_ptr_array_index(inputs, i)));
+  }
+  g_ptr_array_unref(inputs);
+}
+
+static void on_global(void* data,
+                      uint32_t id,
+                      uint32_t permissions,
+                      const char* type,
+                      uint32_t version,
+                      const spa_dict* props) {
+  PipeWireMonitor* self = (PipeWireMonitor*)data;
+
+  if (strcmp(type, PW_TYPE_INTERFACE_Node) == 0) {
+    const gchar* media_class = lookup_prop(props, PW_KEY_MEDIA_CLASS);
+    Node* node = g_new0(Node, 1);
+    if (g_strcmp0(media_class, CAPTURE_MEDIA_CLASS) == 0) {
+      node->kind = NODE_CAPTURE;
+    } else if (is_screencast_source(props)) {
+      node->kind = NODE_SCREEN;
+    } else {
+      node_free(node);
+      return;
+    }
+
+    // The binary name matches how process-based recorders are reported.
+    const gchar* app_name = lookup_prop(props, PW_KEY_APP_PROCESS_BINARY);
+    if (app_name == NULL) app_name = lookup_prop(props, PW_KEY_APP_NAME);
+    const gchar* pid = lookup_prop(props, PW_KEY_APP_PROCESS_ID);
+    node->app_name = g_strdup(app_name != NULL ? app_name : "");
+    node->pid = pid != NULL ? atoi(pid) : 0;
+    g_hash_table_replace(self->nodes, GUINT_TO_POINTER(id), node);
+
+    if (node->kind == NODE_CAPTURE) {
+      update_capture(self, id);
+    } else {
+      update_captures_of_source(self, id);
+    }
+  } else if (strcmp(type, PW_TYPE_INTERFACE_Link) == 0) {
+    const gchar* output = lookup_prop(props, PW_KEY_LINK_OUTPUT_NODE);
+    const gchar* input = lookup_prop(props, PW_KEY_LINK_INPUT_NODE);
+    if (output == NULL || input == NULL) return;
+
+    Link* link = g_new0(Link, 1);
+    link->output_node = (guint32)strtoul(output, NULL, 10);
+    link->input_node = (guint32)strtoul(input, NULL, 10);
+    g_hash_table_replace(self->links, GUINT_TO_POINTER(id), link);
+    update_capture(self, link->input_node);
+  }
+}
+
+static void on_global_remove(void* data, uint32_t id) {
+  PipeWireMonitor* self = (PipeWireMonitor*)data;
+  gpointer key = GUINT_TO_POINTER(id);
+
+  Link* link = (Link*)g_hash_table_lookup(self->links, key);
+  if (link != NULL) {
+    guint32 input_node = link->input_node;
+    g_hash_table_remove(self->links, key);
+    update_capture(self, input_node);
+    return;
+  }
+
+  Node* node = (Node*)g_hash_table_lookup(self->nodes, key);
+  if (node == NULL) return;
+  if (node->kind == NODE_CAPTURE) {
+    if (node->is_reported && self->callback != NULL) {
+      self->callback(id, node->app_name, node->pid, FALSE, self->user_data);
+    }
+    g_hash_table_remove(self->nodes, key);
+  } else {
+    g_hash_table_remove(self->nodes, key);
+    update_captures_of_source(self, id);
+  }
+}
+
+static void on_core_error(void* data,
+                          uint32_t id,
+                          int seq,
+                          int res,
+                          const char* message) {
+  if (id != PW_ID_CORE) return;  // Errors on single objects are harmless.
+  PipeWireMonitor* self = (PipeWireMonitor*)data;
+  g_warning("no_screenshot: PipeWire connection lost: %s", message);
+  self->is_disconnected = TRUE;
+}
+
+static const pw_registry_events kRegistryEvents = {
+    PW_VERSION_REGISTRY_EVENTS,
+    on_global,
+    on_global_remove,
+};
+
+static const pw_core_events kCoreEvents = {
+    PW_VERSION_CORE_EVENTS,
+    NULL,  // info
+    NULL,  // done
+    NULL,  // ping
+    on_core_error,
+};
+
+// Forgets all globals; with |report|, active captures are reported ended.
+static void clear_globals(PipeWireMonitor* self, gboolean report) {
+  if (report && self->callback != NULL) {
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, self->nodes);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+      Node* node = (Node*)value;
+      if (!node->is_reported) continue;
+      node->is_reported = FALSE;
+      self->callback(GPOINTER_TO_UINT(key), node->app_name, node->pid, FALSE,
+                     self->user_data);
+    }
+  }
+  g_hash_table_remove_all(self->nodes);
+  g_hash_table_remove_all(self->links);
+}
+
+static void disconnect(PipeWireMonitor* self) {
+  if (self->loop_watch_id != 0) {
+    g_source_remove(self->loop_watch_id);
+    self->loop_watch_id = 0;
+  }
+  if (self->registry != NULL) {
+    spa_hook_remove(&self->registry_listener);
+    pw_proxy_destroy((pw_proxy*)self->registry);
+    self->registry = NULL;
+  }
+  if (self->core != NULL) {
+    spa_hook_remove(&self->core_listener);
+    pw_core_disconnect(self->core);
+    self->core = NULL;
+  }
+  if (self->context != NULL) {
+    pw_context_destroy(self->context);
+    self->context = NULL;
+  }
+  if (self->loop != NULL) {
+    pw_loop_destroy(self->loop);
+    self->loop = NULL;
+  }
+  self->is_disconnected = FALSE;
+}
+
+static gboolean on_loop_ready(gint fd, GIOCondition condition, gpointer data);
+
+// Connects to the daemon and subscribes to its registry. Returns FALSE,
+// with everything released, if there is no daemon.
+static gboolean connect_to_daemon(PipeWireMonitor* self) {
+  self->loop = pw_loop_new(NULL);
+  self->context = self->loop != NULL ? pw_context_new(self->loop, NULL, 0)
+                                     : NULL;
+  if (self->context != NULL) {
+    pw_properties* props =
+        self->remote_name != NULL
+            ? pw_properties_new(PW_KEY_REMOTE_NAME, self->remote_name, NULL)
+            : NULL;
+    self->core = pw_context_connect(self->context, props, 0);
+  }
+  if (self->core == NULL) {
+    disconnect(self);
+    return FALSE;
+  }
+
+  pw_core_add_listener(self->core, &self->core_listener, &kCoreEvents, self);
+  self->registry = pw_core_get_registry(self->core, PW_VERSION_REGISTRY, 0);
+  pw_registry_add_listener(self->registry, &self->registry_listener,
+                           &kRegistryEvents, self);
+  self->loop_watch_id =
+      g_unix_fd_add(pw_loop_get_fd(self->loop), G_IO_IN, on_loop_ready, self);
+  return TRUE;
+}
+
+static gboolean on_reconnect(gpointer data);
+
+static void schedule_reconnect(PipeWireMonitor* self) {
+  self->reconnect_id =
+      g_timeout_add(self->reconnect_delay_ms, on_reconnect, self);
+  self->reconnect_delay_ms =
+      MIN(self->reconnect_delay_ms * 2, RECONNECT_MAX_DELAY_MS);
+}
+
+static gboolean on_reconnect(gpointer data) {
+  PipeWireMonitor* self = (PipeWireMonitor*)data;
+  self->reconnect_id = 0;
+  if (connect_to_daemon(self)) {
+    g_message("no_screenshot: reconnected to PipeWire");
+    self->reconnect_delay_ms = RECONNECT_MIN_DELAY_MS;
+  } else {
+    schedule_reconnect(self);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean on_loop_ready(gint fd, GIOCondition condition, gpointer data) {
+  PipeWireMonitor* self = (PipeWireMonitor*)data;
+  pw_loop_enter(self->loop);
+  pw_loop_iterate(self->loop, 0);
+  pw_loop_leave(self->loop);
+
+  if (!self->is_disconnected) return G_SOURCE_CONTINUE;
+
+  // The daemon went away (e.g. restarted); its streams went with it. The
+  // registry of the next daemon reports the streams it has anew.
+  self->loop_watch_id = 0;  // Removed by returning G_SOURCE_REMOVE.
+  clear_globals(self, TRUE);
+  disconnect(self);
+  schedule_reconnect(self);
+  return G_SOURCE_REMOVE;
+}
+
+#endif  // NO_SCREENSHOT_HAVE_PIPEWIRE
+
+PipeWireMonitor* pipewire_monitor_new(const gchar* remote_name,
+                                      PipeWireCaptureCallback cb,
+                                      gpointer user_data) {
+  PipeWireMonitor* self = g_new0(PipeWireMonitor, 1);
+  self->callback = cb;
+  self->user_data = user_data;
+  self->remote_name = g_strdup(remote_name);
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+  self->reconnect_delay_ms = RECONNECT_MIN_DELAY_MS;
+  self->nodes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                      node_free);
+  self->links =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+#endif
+  return self;
+}
+
+void pipewire_monitor_free(PipeWireMonitor* self) {
+  if (self == NULL) return;
+  pipewire_monitor_stop(self);
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+  g_hash_table_unref(self->nodes);
+  g_hash_table_unref(self->links);
+#endif
+  g_free(self->remote_name);
+  g_free(self);
+}
+
+void pipewire_monitor_start(PipeWireMonitor* self) {
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+  // Already started, or waiting to reconnect.
+  if (self->loop != NULL || self->reconnect_id != 0) return;
+
+  static gboolean is_initialized = FALSE;
+  if (!is_initialized) {
+    pw_init(NULL, NULL);
+    is_initialized = TRUE;
+  }
+
+  if (!connect_to_daemon(self)) {
+    g_message("no_screenshot: no PipeWire daemon, capture streams unwatched");
+  }
+#endif
+}
+
+void pipewire_monitor_stop(PipeWireMonitor* self) {
+#ifdef NO_SCREENSHOT_HAVE_PIPEWIRE
+  if (self->reconnect_id != 0) {
+    g_source_remove(self->reconnect_id);
+    self->reconnect_id = 0;
+  }
+  self->reconnect_delay_ms = RECONNECT_MIN_DELAY_MS;
+  disconnect(self);
+  clear_globals(self, FALSE);
+#endif
+}
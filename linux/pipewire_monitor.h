@@ -0,0 +1,40 @@
+#ifndef PIPEWIRE_MONITOR_H_
+#define PIPEWIRE_MONITOR_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Listens to the PipeWire registry for video capture streams: nodes of
+// media class Stream/Input/Video linked to a screencast source — a video
+// node with media.role "Screen" or published by a compositor or
+// xdg-desktop-portal backend. Every portal screen capture on a PipeWire
+// desktop shows up this way, sandboxed apps included; cameras do not.
+// Purely event-driven; when the daemon goes away its captures are reported
+// ended and the monitor reconnects, backing off while it stays away.
+//
+// Only functional when built against libpipewire-0.3
+// (NO_SCREENSHOT_HAVE_PIPEWIRE); otherwise start/stop are no-ops.
+typedef struct _PipeWireMonitor PipeWireMonitor;
+
+// Invoked when a capture stream starts or stops. |app_name| and |pid| name
+// the consuming application (empty / 0 when unknown).
+typedef void (*PipeWireCaptureCallback)(guint32 node_id,
+                                        const gchar* app_name,
+                                        gint pid,
+                                        gboolean is_active,
+                                        gpointer user_data);
+
+// |remote_name| selects a PipeWire daemon other than the default (NULL),
+// e.g. a locally started one in tests.
+PipeWireMonitor* pipewire_monitor_new(const gchar* remote_name,
+                                      PipeWireCaptureCallback cb,
+                                      gpointer user_data);
+void pipewire_monitor_free(PipeWireMonitor* self);
+
+void pipewire_monitor_start(PipeWireMonitor* self);
+void pipewire_monitor_stop(PipeWireMonitor* self);
+
+G_END_DECLS
+
+#endif  // PIPEWIRE_MONITOR_H_
@@ -0,0 +1,143 @@
+#include "poll_scheduler.h"
+
+// Each idle poll multiplies the interval by this much.
+#define BACKOFF_FACTOR 2
+
+// From here on, timeouts are second-granular so GLib can batch their
+// wakeups with other timers.
+#define COARSE_INTERVAL_MS 2000
+
+struct _PollScheduler {
+  PollFunc func;
+  gpointer user_data;
+  PollSchedulerConfig config;
+
+  gboolean is_started;
+  gboolean is_attentive;
+  guint interval_ms;
+  guint timer_id;
+
+  // A trigger while polling resets the interval once the poll is done.
+  gboolean is_polling;
+  gboolean is_reset_pending;
+};
+
+static void sanitize_config(PollSchedulerConfig* config) {
+  if (config->min_interval_ms == 0) config->min_interval_ms = 1;
+  if (config->max_interval_ms < config->min_interval_ms) {
+    config->max_interval_ms = config->min_interval_ms;
+  }
+  if (config->cpu_budget <= 0 || config->cpu_budget > 1) {
+    config->cpu_budget = POLL_SCHEDULER_DEFAULT_CPU_BUDGET;
+  }
+}
+
+static gboolean on_timer(gpointer user_data);
+
+static void schedule(PollScheduler* self) {
+  if (self->timer_id != 0) g_source_remove(self->timer_id);
+  self->timer_id =
+      self->interval_ms >= COARSE_INTERVAL_MS
+          ? g_timeout_add_seconds(self->interval_ms / 1000, on_timer, self)
+          : g_timeout_add(self->interval_ms, on_timer, self);
+}
+
+// Polls and schedules the next poll. With |is_reset| the back-off restarts
+// from the minimum interval.
+static void run_poll(PollScheduler* self, gboolean is_reset) {
+  gint64 begin_us = g_get_monotonic_time();
+  self->is_polling = TRUE;
+  gboolean is_busy = self->func(self->user_data);
+  self->is_polling = FALSE;
+  gint64 cost_ms = (g_get_monotonic_time() - begin_us) / 1000;
+
+  is_reset = is_reset || self->is_reset_pending;
+  self->is_reset_pending = FALSE;
+
+  if (is_reset || is_busy || self->is_attentive) {
+    self->interval_ms = self->config.min_interval_ms;
+  } else {
+    self->interval_ms = MIN(self->interval_ms * BACKOFF_FACTOR,
+                            self->config.max_interval_ms);
+  }
+
+  // A poll costing |cost_ms| may run at most every cost_ms / budget.
+  guint floor_ms = (guint)(cost_ms / self->config.cpu_budget);
+  self->interval_ms = MAX(self->interval_ms, floor_ms);
+
+  // The poll function may have stopped the scheduler.
+  if (self->is_started) schedule(self);
+}
+
+static gboolean on_timer(gpointer user_data) {
+  PollScheduler* self = (PollScheduler*)user_data;
+  self->timer_id = 0;  // Removed by returning G_SOURCE_REMOVE.
+  run_poll(self, FALSE);
+  return G_SOURCE_REMOVE;
+}
+
+PollScheduler* poll_scheduler_new(const PollSchedulerConfig* config,
+                                  PollFunc func,
+                                  gpointer user_data) {
+  PollScheduler* self = g_new0(PollScheduler, 1);
+  self->func = func;
+  self->user_data = user_data;
+  self->config.min_interval_ms = POLL_SCHEDULER_DEFAULT_MIN_INTERVAL_MS;
+  self->config.max_interval_ms = POLL_SCHEDULER_DEFAULT_MAX_INTERVAL_MS;
+  self->config.cpu_budget = POLL_SCHEDULER_DEFAULT_CPU_BUDGET;
+  if (config != NULL) poll_scheduler_set_config(self, config);
+  self->interval_ms = self->config.min_interval_ms;
+  return self;
+}
+
+void poll_scheduler_free(PollScheduler* self) {
+  if (self == NULL) return;
+  poll_scheduler_stop(self);
+  g_free(self);
+}
+
+void poll_scheduler_start(PollScheduler* self) {
+  if (self->is_started) return;
+  self->is_started = TRUE;
+  poll_scheduler_trigger(self);
+}
+
+void poll_scheduler_stop(PollScheduler* self) {
+  self->is_started = FALSE;
+  if (self->timer_id != 0) {
+    g_source_remove(self->timer_id);
+    self->timer_id = 0;
+  }
+}
+
+void poll_scheduler_set_config(PollScheduler* self,
+                               const PollSchedulerConfig* config) {
+  self->config = *config;
+  sanitize_config(&self->config);
+  self->interval_ms = CLAMP(self->interval_ms, self->config.min_interval_ms,
+                            self->config.max_interval_ms);
+  if (self->is_started) schedule(self);
+}
+
+void poll_scheduler_set_attentive(PollScheduler* self, gboolean is_attentive) {
+  if (self->is_attentive == is_attentive) return;
+  self->is_attentive = is_attentive;
+  if (is_attentive) poll_scheduler_trigger(self);
+}
+
+void poll_scheduler_trigger(PollScheduler* self) {
+  if (!self->is_started) return;
+  if (self->is_polling) {
+    self->is_reset_pending = TRUE;
+    return;
+  }
+  if (self->timer_id != 0) {
+    g_source_remove(self->timer_id);
+    self->timer_id = 0;
+  }
+  run_poll(self, TRUE);
+}
+
+guint poll_scheduler_get_interval(PollScheduler* self) {
+  return self->interval_ms;
+}
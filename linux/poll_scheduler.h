@@ -0,0 +1,53 @@
+#ifndef POLL_SCHEDULER_H_
+#define POLL_SCHEDULER_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Runs a poll function at an adaptive interval: the minimum while the user
+// is attentive or something just happened, backing off exponentially to the
+// maximum otherwise. The interval never drops below what keeps the poll
+// within its CPU budget.
+typedef struct _PollScheduler PollScheduler;
+
+#define POLL_SCHEDULER_DEFAULT_MIN_INTERVAL_MS 1000
+#define POLL_SCHEDULER_DEFAULT_MAX_INTERVAL_MS 16000
+#define POLL_SCHEDULER_DEFAULT_CPU_BUDGET 0.01
+
+typedef struct {
+  guint min_interval_ms;
+  guint max_interval_ms;
+  gdouble cpu_budget;  // Fraction of one core the poll may use, e.g. 0.01.
+} PollSchedulerConfig;
+
+// Performs one poll. Returns TRUE if it saw activity (e.g. a burst of new
+// processes) that warrants polling quickly again.
+typedef gboolean (*PollFunc)(gpointer user_data);
+
+// |config| may be NULL for the defaults.
+PollScheduler* poll_scheduler_new(const PollSchedulerConfig* config,
+                                  PollFunc func,
+                                  gpointer user_data);
+void poll_scheduler_free(PollScheduler* self);
+
+// Polls immediately, then keeps polling until stopped.
+void poll_scheduler_start(PollScheduler* self);
+void poll_scheduler_stop(PollScheduler* self);
+
+void poll_scheduler_set_config(PollScheduler* self,
+                               const PollSchedulerConfig* config);
+
+// While attentive, polls at the minimum interval. Becoming attentive polls
+// immediately.
+void poll_scheduler_set_attentive(PollScheduler* self, gboolean is_attentive);
+
+// Polls immediately and restarts the back-off from the minimum interval.
+void poll_scheduler_trigger(PollScheduler* self);
+
+// Current delay before the next poll; for diagnostics.
+guint poll_scheduler_get_interval(PollScheduler* self);
+
+G_END_DECLS
+
+#endif  // POLL_SCHEDULER_H_
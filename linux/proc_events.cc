@@ -0,0 +1,277 @@
+#include "proc_events.h"
+
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Large enough for a full batch of proc connector messages per recv().
+#define RECV_BUFFER_SIZE 8192
+
+// Current kernels ack LISTEN before send() returns; older ones defer it to a
+// workqueue. Callers outside the initial namespaces never get one.
+#define ACK_TIMEOUT_MS 5000
+
+// Linux 6.6 moved the event enum out of struct proc_event, which changes how
+// C++ has to name its values.
+#ifdef PROC_EVENT_ALL
+#define PROC_EVENT(name) name
+#else
+#define PROC_EVENT(name) proc_event::name
+#endif
+
+struct _ProcEvents {
+  ProcEventCallback callback;
+  gpointer user_data;
+
+  int socket_fd;
+  guint watch_id;
+  guint ack_timeout_id;
+  // Set once the kernel acknowledged LISTEN. Neither a bound socket nor
+  // arriving events prove the subscription: inside a user namespace the
+  // kernel ignores LISTEN, and events flow only while another listener
+  // happens to exist.
+  gboolean is_confirmed;
+  int refused_error;  // The error the kernel acknowledged LISTEN with.
+};
+
+static gboolean send_mcast_op(int fd, enum proc_cn_mcast_op op) {
+  char buffer[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(op))]
+      __attribute__((aligned(NLMSG_ALIGNTO)));
+  memset(buffer, 0, sizeof(buffer));
+
+  struct nlmsghdr* header = (struct nlmsghdr*)buffer;
+  header->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+  header->nlmsg_type = NLMSG_DONE;
+
+  struct cn_msg* message = (struct cn_msg*)NLMSG_DATA(header);
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->len = sizeof(op);
+  memcpy(message->data, &op, sizeof(op));
+
+  return send(fd, buffer, header->nlmsg_len, 0) == (ssize_t)header->nlmsg_len;
+}
+
+static void dispatch_event(ProcEvents* self, const struct proc_event* event) {
+  switch (event->what) {
+    case PROC_EVENT(PROC_EVENT_EXEC):
+      self->callback(PROC_EVENTS_EXEC, event->event_data.exec.process_tgid,
+                     NULL, self->user_data);
+      break;
+
+    case PROC_EVENT(PROC_EVENT_COMM): {
+      // Only the main thread's name shows up in /proc/<pid>/comm.
+      if (event->event_data.comm.process_pid !=
+          event->event_data.comm.process_tgid) {
+        break;
+      }
+      gchar comm[sizeof(event->event_data.comm.comm) + 1];
+      memcpy(comm, event->event_data.comm.comm, sizeof(comm) - 1);
+      comm[sizeof(comm) - 1] = '\0';
+      self->callback(PROC_EVENTS_COMM, event->event_data.comm.process_tgid,
+                     comm, self->user_data);
+      break;
+    }
+
+    case PROC_EVENT(PROC_EVENT_EXIT):
+      // Thread exits are reported too; only the leader ends the process.
+      if (event->event_data.exit.process_pid !=
+          event->event_data.exit.process_tgid) {
+        break;
+      }
+      self->callback(PROC_EVENTS_EXIT, event->event_data.exit.process_tgid,
+                     NULL, self->user_data);
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void handle_event(ProcEvents* self,
+                         const struct proc_event* event,
+                         gboolean should_dispatch) {
+  if (event->what != PROC_EVENT(PROC_EVENT_NONE)) {
+    if (should_dispatch) dispatch_event(self, event);
+    return;
+  }
+
+  // The kernel answers LISTEN with an event carrying only an error code.
+  if (self->is_confirmed) return;
+  if (event->event_data.ack.err != 0) {
+    self->refused_error = (int)event->event_data.ack.err;
+    return;
+  }
+  self->is_confirmed = TRUE;
+  if (self->ack_timeout_id != 0) {
+    g_source_remove(self->ack_timeout_id);
+    self->ack_timeout_id = 0;
+  }
+  if (should_dispatch) {
+    g_message("no_screenshot: subscribed to process events");
+    self->callback(PROC_EVENTS_CONFIRMED, 0, NULL, self->user_data);
+  }
+}
+
+// Reads everything queued on the socket. Without |should_dispatch| it only
+// looks for the subscription ack.
+static void drain_socket(ProcEvents* self, gboolean should_dispatch) {
+  char buffer[RECV_BUFFER_SIZE] __attribute__((aligned(NLMSG_ALIGNTO)));
+  for (;;) {
+    struct sockaddr_nl from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n = recvfrom(self->socket_fd, buffer, sizeof(buffer), 0,
+                         (struct sockaddr*)&from, &from_len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == ENOBUFS) {
+        // The socket buffer overflowed under a process storm.
+        if (should_dispatch) {
+          self->callback(PROC_EVENTS_OVERRUN, 0, NULL, self->user_data);
+        }
+        continue;
+      }
+      break;  // EAGAIN — drained.
+    }
+    if (from.nl_pid != 0) continue;  // Not sent by the kernel.
+
+    int len = (int)n;
+    for (struct nlmsghdr* header = (struct nlmsghdr*)buffer;
+         NLMSG_OK(header, len); header = NLMSG_NEXT(header, len)) {
+      if (header->nlmsg_type == NLMSG_ERROR ||
+          header->nlmsg_type == NLMSG_NOOP) {
+        continue;
+      }
+      const struct cn_msg* message = (const struct cn_msg*)NLMSG_DATA(header);
+      if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC ||
+          message->len < sizeof(struct proc_event)) {
+        continue;
+      }
+      handle_event(self, (const struct proc_event*)message->data,
+                   should_dispatch);
+    }
+  }
+}
+
+static gboolean on_socket_ready(gint fd,
+                                GIOCondition condition,
+                                gpointer user_data) {
+  ProcEvents* self = (ProcEvents*)user_data;
+
+  if (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+    g_warning("no_screenshot: process event socket failed");
+    self->watch_id = 0;
+    self->callback(PROC_EVENTS_FAILED, 0, NULL, self->user_data);
+    return G_SOURCE_REMOVE;
+  }
+
+  drain_socket(self, TRUE);
+  if (self->refused_error != 0) {
+    g_message("no_screenshot: process events refused (%s)",
+              g_strerror(self->refused_error));
+    g_source_remove(self->ack_timeout_id);
+    self->ack_timeout_id = 0;
+    self->watch_id = 0;
+    self->callback(PROC_EVENTS_FAILED, 0, NULL, self->user_data);
+    return G_SOURCE_REMOVE;
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_ack_timeout(gpointer user_data) {
+  ProcEvents* self = (ProcEvents*)user_data;
+  g_message("no_screenshot: process event subscription not acknowledged");
+  self->ack_timeout_id = 0;
+  g_source_remove(self->watch_id);
+  self->watch_id = 0;
+  self->callback(PROC_EVENTS_FAILED, 0, NULL, self->user_data);
+  return G_SOURCE_REMOVE;
+}
+
+ProcEvents* proc_events_new(ProcEventCallback cb, gpointer user_data) {
+  ProcEvents* self = g_new0(ProcEvents, 1);
+  self->callback = cb;
+  self->user_data = user_data;
+  self->socket_fd = -1;
+  return self;
+}
+
+void proc_events_free(ProcEvents* self) {
+  if (self == NULL) return;
+  proc_events_stop(self);
+  g_free(self);
+}
+
+gboolean proc_events_start(ProcEvents* self) {
+  if (self->socket_fd >= 0) return TRUE;  // Already started.
+
+  int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  NETLINK_CONNECTOR);
+  if (fd < 0) return FALSE;
+
+  struct sockaddr_nl address;
+  memset(&address, 0, sizeof(address));
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+  address.nl_pid = 0;  // Let the kernel assign a port id.
+
+  // Joining the proc connector group needs CAP_NET_ADMIN.
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      !send_mcast_op(fd, PROC_CN_MCAST_LISTEN)) {
+    g_message("no_screenshot: process events unavailable (%s)",
+              g_strerror(errno));
+    close(fd);
+    return FALSE;
+  }
+
+  // Events queued before the ack predate the caller's initial scan.
+  self->socket_fd = fd;
+  self->is_confirmed = FALSE;
+  self->refused_error = 0;
+  drain_socket(self, FALSE);
+  if (self->refused_error != 0) {
+    g_message("no_screenshot: process events refused (%s)",
+              g_strerror(self->refused_error));
+    close(fd);
+    self->socket_fd = -1;
+    return FALSE;
+  }
+
+  self->watch_id = g_unix_fd_add(
+      fd, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP), on_socket_ready,
+      self);
+  if (self->is_confirmed) {
+    g_message("no_screenshot: subscribed to process events");
+  } else {
+    self->ack_timeout_id = g_timeout_add(ACK_TIMEOUT_MS, on_ack_timeout, self);
+  }
+  return TRUE;
+}
+
+void proc_events_stop(ProcEvents* self) {
+  if (self->ack_timeout_id != 0) {
+    g_source_remove(self->ack_timeout_id);
+    self->ack_timeout_id = 0;
+  }
+  if (self->watch_id != 0) {
+    g_source_remove(self->watch_id);
+    self->watch_id = 0;
+  }
+  if (self->socket_fd >= 0) {
+    send_mcast_op(self->socket_fd, PROC_CN_MCAST_IGNORE);
+    close(self->socket_fd);
+    self->socket_fd = -1;
+  }
+  self->is_confirmed = FALSE;
+}
+
+gboolean proc_events_is_confirmed(ProcEvents* self) {
+  return self->is_confirmed;
+}
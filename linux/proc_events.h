@@ -0,0 +1,44 @@
+#ifndef PROC_EVENTS_H_
+#define PROC_EVENTS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Process lifecycle notifications from the kernel's netlink proc connector.
+// Subscribing needs CAP_NET_ADMIN in the initial user namespace; without it
+// proc_events_start() fails and callers fall back to polling /proc.
+typedef struct _ProcEvents ProcEvents;
+
+typedef enum {
+  PROC_EVENTS_CONFIRMED,  // The kernel acknowledged the subscription late.
+  PROC_EVENTS_EXEC,       // |pid| replaced its program image.
+  PROC_EVENTS_COMM,       // |pid| renamed itself to |comm|.
+  PROC_EVENTS_EXIT,       // |pid| exited.
+  PROC_EVENTS_OVERRUN,    // Events were dropped; rescan everything.
+  PROC_EVENTS_FAILED,     // The subscription failed; no further events.
+} ProcEventKind;
+
+// Invoked on the main loop for each process (not thread) event. |comm| is
+// only set for PROC_EVENTS_COMM.
+typedef void (*ProcEventCallback)(ProcEventKind kind,
+                                  gint pid,
+                                  const gchar* comm,
+                                  gpointer user_data);
+
+ProcEvents* proc_events_new(ProcEventCallback cb, gpointer user_data);
+void proc_events_free(ProcEvents* self);
+
+// Returns FALSE if the proc connector is unavailable or the kernel refused
+// the subscription. Events are only certain to arrive once the kernel
+// acknowledged it: until proc_events_is_confirmed() is TRUE or
+// PROC_EVENTS_CONFIRMED arrives, callers should keep polling. Without an ack
+// PROC_EVENTS_FAILED follows after a few seconds.
+gboolean proc_events_start(ProcEvents* self);
+void proc_events_stop(ProcEvents* self);
+
+gboolean proc_events_is_confirmed(ProcEvents* self);
+
+G_END_DECLS
+
+#endif  // PROC_EVENTS_H_
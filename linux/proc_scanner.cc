@@ -0,0 +1,357 @@
+#include "proc_scanner.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cgroup_scope.h"
+#include "dir_scan.h"
+
+// /proc/<pid>/stat up to the start time (field 22) fits comfortably.
+#define STAT_BUFFER_SIZE 512
+#define COMM_MAX 64
+
+typedef struct {
+  guint64 inode;       // Of /proc/<pid>; changes when the PID is reused.
+  guint64 start_time;  // Clock ticks after boot.
+  guint generation;    // Last sweep that saw this PID.
+  // A process found mid fork+exec still has its parent's name, so new
+  // entries are read once more on the following sweep.
+  gboolean is_settled;
+  gchar comm[COMM_MAX];
+} ProcEntry;
+
+typedef struct {
+  gint pid;
+  guint64 inode;
+} PendingRead;
+
+typedef struct {
+  gchar path[32];  // "<pid>/stat", relative to the /proc dirfd.
+  ssize_t len;
+  gchar buffer[STAT_BUFFER_SIZE];
+} StatRead;
+
+struct _ProcScanner {
+  ProcScanFunc func;
+  gpointer user_data;
+
+  int proc_fd;
+  int scope_fd;  // cgroup whose processes are swept, or -1 for all of /proc.
+  GHashTable* entries;  // pid → ProcEntry*
+  guint generation;
+  gboolean is_full_scan;
+  GArray* pending;  // PendingRead, filled during a sweep.
+};
+
+static gboolean parse_pid(const gchar* name, gint* pid) {
+  if (name[0] == '\0') return FALSE;
+  gint value = 0;
+  for (const gchar* p = name; *p != '\0'; p++) {
+    if (*p < '0' || *p > '9') return FALSE;
+    value = value * 10 + (*p - '0');
+  }
+  *pid = value;
+  return TRUE;
+}
+
+// Parses "pid (comm) state ppid ... starttime ...". The name may itself
+// contain ") ", so it ends at the last ')'.
+static gboolean parse_stat(const gchar* line,
+                           gchar* comm,
+                           gsize comm_size,
+                           guint64* start_time) {
+  const gchar* open_paren = strchr(line, '(');
+  const gchar* close_paren = strrchr(line, ')');
+  if (open_paren == NULL || close_paren == NULL || close_paren < open_paren) {
+    return FALSE;
+  }
+  gsize len = MIN((gsize)(close_paren - open_paren - 1), comm_size - 1);
+  memcpy(comm, open_paren + 1, len);
+  comm[len] = '\0';
+
+  // Fields after the name are single-space separated, starting at field 3.
+  const gchar* p = close_paren + 1;
+  for (int field = 3; field < 22; field++) {
+    p = strchr(p + 1, ' ');
+    if (p == NULL) return FALSE;
+  }
+  *start_time = g_ascii_strtoull(p + 1, NULL, 10);
+  return TRUE;
+}
+
+static void stat_read_init(StatRead* read, gint pid) {
+  g_snprintf(read->path, sizeof(read->path), "%d/stat", pid);
+  read->len = -1;
+}
+
+// One openat() on the held /proc dirfd and one read() into |read|.
+static void read_stat_sync(int proc_fd, StatRead* read) {
+  int fd = openat(proc_fd, read->path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  read->len = ::read(fd, read->buffer, sizeof(read->buffer) - 1);
+  close(fd);
+}
+
+// Applies a completed read of |pid|, reporting changes. Returns FALSE if
+// the process is gone.
+static gboolean apply_read(ProcScanner* self,
+                           gint pid,
+                           guint64 inode,
+                           StatRead* read) {
+  if (read->len <= 0) return FALSE;
+  read->buffer[read->len] = '\0';
+
+  gchar comm[COMM_MAX];
+  guint64 start_time = 0;
+  if (!parse_stat(read->buffer, comm, sizeof(comm), &start_time)) {
+    return FALSE;
+  }
+
+  ProcEntry* entry =
+      (ProcEntry*)g_hash_table_lookup(self->entries, GINT_TO_POINTER(pid));
+  gboolean is_new = entry == NULL || entry->start_time != start_time;
+  if (entry == NULL) {
+    entry = g_new0(ProcEntry, 1);
+    g_hash_table_insert(self->entries, GINT_TO_POINTER(pid), entry);
+  }
+  gboolean changed = is_new || strcmp(entry->comm, comm) != 0;
+
+  entry->inode = inode;
+  entry->start_time = start_time;
+  entry->generation = self->generation;
+  entry->is_settled = !is_new;
+  g_strlcpy(entry->comm, comm, sizeof(entry->comm));
+
+  if (changed && self->func != NULL) {
+    self->func(pid, start_time, comm, self->user_data);
+  }
+  return TRUE;
+}
+
+// Reads every PID queued by the sweep. Processes that exited meanwhile are
+// dropped at the end of the sweep.
+static void read_pending(ProcScanner* self) {
+  GArray* pending = self->pending;
+  StatRead read;
+  for (guint i = 0; i < pending->len; i++) {
+    const PendingRead* queued = &g_array_index(pending, PendingRead, i);
+    stat_read_init(&read, queued->pid);
+    read_stat_sync(self->proc_fd, &read);
+    apply_read(self, queued->pid, queued->inode, &read);
+  }
+  g_array_set_size(pending, 0);
+}
+
+// Queues |pid| for a read unless its cached entry is still current: same
+// /proc/<pid> |inode|, so the PID has not been reused.
+static void visit_pid(ProcScanner* self, gint pid, guint64 inode) {
+  ProcEntry* entry =
+      (ProcEntry*)g_hash_table_lookup(self->entries, GINT_TO_POINTER(pid));
+  if (entry != NULL && entry->inode == inode && entry->is_settled &&
+      !self->is_full_scan) {
+    entry->generation = self->generation;  // Unchanged — no syscall.
+    return;
+  }
+
+  PendingRead read = {pid, inode};
+  g_array_append_val(self->pending, read);
+}
+
+static gboolean on_proc_entry(const gchar* name,
+                              guchar d_type,
+                              guint64 inode,
+                              gpointer data) {
+  gint pid;
+  if (d_type != DT_DIR && d_type != DT_UNKNOWN) return TRUE;
+  if (!parse_pid(name, &pid)) return TRUE;
+  visit_pid((ProcScanner*)data, pid, inode);
+  return TRUE;
+}
+
+// cgroup.procs lists bare PIDs, so their inodes take one stat each.
+static void on_cgroup_pid(gint pid, gpointer data) {
+  ProcScanner* self = (ProcScanner*)data;
+  gchar name[16];
+  g_snprintf(name, sizeof(name), "%d", pid);
+  struct stat st;
+  // Exited meanwhile: dropped at the end of the sweep.
+  if (fstatat(self->proc_fd, name, &st, 0) != 0) return;
+  visit_pid(self, pid, st.st_ino);
+}
+
+ProcScanner* proc_scanner_new(const gchar* proc_root,
+                              ProcScanFunc func,
+                              gpointer user_data) {
+  ProcScanner* self = g_new0(ProcScanner, 1);
+  self->func = func;
+  self->user_data = user_data;
+  self->entries = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                        g_free);
+  self->pending = g_array_new(FALSE, FALSE, sizeof(PendingRead));
+  self->scope_fd = -1;
+
+  const gchar* root = proc_root != NULL ? proc_root : "/proc";
+  self->proc_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (self->proc_fd < 0) {
+    g_warning("no_screenshot: cannot open %s", root);
+  }
+  return self;
+}
+
+void proc_scanner_free(ProcScanner* self) {
+  if (self == NULL) return;
+  if (self->proc_fd >= 0) close(self->proc_fd);
+  if (self->scope_fd >= 0) close(self->scope_fd);
+  g_hash_table_unref(self->entries);
+  g_array_unref(self->pending);
+  g_free(self);
+}
+
+gboolean proc_scanner_scan(ProcScanner* self, gboolean full) {
+  if (self->proc_fd < 0) return FALSE;
+
+  self->generation++;
+  self->is_full_scan = full;
+  gboolean ok = FALSE;
+  if (self->scope_fd >= 0) {
+    ok = cgroup_scope_foreach_pid(self->scope_fd, on_cgroup_pid, self);
+    if (!ok) {
+      // The scope is gone; sweep everything from now on.
+      g_warning("no_screenshot: cgroup scope unreadable, scanning all of "
+                "/proc");
+      close(self->scope_fd);
+      self->scope_fd = -1;
+      g_array_set_size(self->pending, 0);
+    }
+  }
+  if (!ok) ok = dir_scan(self->proc_fd, on_proc_entry, self);
+  read_pending(self);
+  if (!ok) return FALSE;
+
+  // Whatever the sweep did not see has exited.
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->entries);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    ProcEntry* entry = (ProcEntry*)value;
+    if (entry->generation == self->generation) continue;
+
+    gint pid = GPOINTER_TO_INT(key);
+    guint64 start_time = entry->start_time;
+    g_hash_table_iter_remove(&iter);
+    if (self->func != NULL) {
+      self->func(pid, start_time, NULL, self->user_data);
+    }
+  }
+  return TRUE;
+}
+
+gboolean proc_scanner_set_scope(ProcScanner* self, const gchar* cgroup_dir) {
+  if (self->scope_fd >= 0) {
+    close(self->scope_fd);
+    self->scope_fd = -1;
+  }
+  if (cgroup_dir == NULL) return TRUE;
+
+  self->scope_fd = open(cgroup_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  return self->scope_fd >= 0;
+}
+
+void proc_scanner_refresh(ProcScanner* self, gint pid) {
+  if (self->proc_fd < 0) return;
+
+  ProcEntry* entry =
+      (ProcEntry*)g_hash_table_lookup(self->entries, GINT_TO_POINTER(pid));
+  StatRead read;
+  stat_read_init(&read, pid);
+  read_stat_sync(self->proc_fd, &read);
+  // The inode is only known from a sweep; keeping the cached one (or 0)
+  // costs at most one extra read on the next sweep.
+  if (!apply_read(self, pid, entry != NULL ? entry->inode : 0, &read)) {
+    proc_scanner_forget(self, pid);
+  }
+}
+
+gboolean proc_scanner_is_same_process(ProcScanner* self,
+                                      gint pid,
+                                      guint64 start_time) {
+  if (self->proc_fd < 0) return FALSE;
+
+  StatRead read;
+  stat_read_init(&read, pid);
+  read_stat_sync(self->proc_fd, &read);
+  if (read.len <= 0) return FALSE;
+  read.buffer[read.len] = '\0';
+
+  gchar comm[COMM_MAX];
+  guint64 current_start_time = 0;
+  return parse_stat(read.buffer, comm, sizeof(comm), &current_start_time) &&
+         current_start_time == start_time;
+}
+
+int proc_scanner_open(ProcScanner* self,
+                      gint pid,
+                      const gchar* name,
+                      int flags) {
+  gchar path[64];
+  g_snprintf(path, sizeof(path), "%d/%s", pid, name);
+  return openat(self->proc_fd, path, flags | O_CLOEXEC);
+}
+
+gssize proc_scanner_read_file(ProcScanner* self,
+                              gint pid,
+                              const gchar* name,
+                              gchar* buffer,
+                              gsize size) {
+  int fd = proc_scanner_open(self, pid, name, O_RDONLY);
+  if (fd < 0) return -1;
+  gssize n = read(fd, buffer, size);
+  close(fd);
+  return n;
+}
+
+gboolean proc_scanner_read_link(ProcScanner* self,
+                                gint pid,
+                                const gchar* name,
+                                gchar* buffer,
+                                gsize size) {
+  gchar path[64];
+  g_snprintf(path, sizeof(path), "%d/%s", pid, name);
+  gssize n = readlinkat(self->proc_fd, path, buffer, size - 1);
+  if (n < 0) return FALSE;
+  buffer[n] = '\0';
+  return TRUE;
+}
+
+void proc_scanner_foreach(ProcScanner* self,
+                          ProcScanFunc func,
+                          gpointer user_data) {
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->entries);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    const ProcEntry* entry = (const ProcEntry*)value;
+    func(GPOINTER_TO_INT(key), entry->start_time, entry->comm, user_data);
+  }
+}
+
+void proc_scanner_forget(ProcScanner* self, gint pid) {
+  ProcEntry* entry =
+      (ProcEntry*)g_hash_table_lookup(self->entries, GINT_TO_POINTER(pid));
+  if (entry == NULL) return;
+
+  guint64 start_time = entry->start_time;
+  g_hash_table_remove(self->entries, GINT_TO_POINTER(pid));
+  if (self->func != NULL) {
+    self->func(pid, start_time, NULL, self->user_data);
+  }
+}
+
+void proc_scanner_clear(ProcScanner* self) {
+  g_hash_table_remove_all(self->entries);
+}
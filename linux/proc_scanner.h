@@ -0,0 +1,81 @@
+#ifndef PROC_SCANNER_H_
+#define PROC_SCANNER_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Incremental view of the process list. Processes are cached by PID and
+// start time, so a sweep only reads /proc/<pid>/stat for PIDs it has not
+// seen before; in steady state a sweep is a single getdents64 pass.
+typedef struct _ProcScanner ProcScanner;
+
+// Called when a process appears or its name changes (|comm| set) and when it
+// goes away (|comm| NULL). |start_time| is in clock ticks after boot.
+typedef void (*ProcScanFunc)(gint pid,
+                             guint64 start_time,
+                             const gchar* comm,
+                             gpointer user_data);
+
+// |proc_root| is normally "/proc" (NULL); other roots are for benchmarks.
+ProcScanner* proc_scanner_new(const gchar* proc_root,
+                              ProcScanFunc func,
+                              gpointer user_data);
+void proc_scanner_free(ProcScanner* self);
+
+// Sweeps the process list and reports changes. With |full| every process is
+// re-read. Returns FALSE if the process list could not be read.
+gboolean proc_scanner_scan(ProcScanner* self, gboolean full);
+
+// Limits sweeps to the processes of the cgroup directory |cgroup_dir| and
+// its descendants (see cgroup_scope.h); NULL sweeps all of /proc again.
+// Processes outside the scope are reported gone on the next sweep. Returns
+// FALSE if the directory cannot be opened, leaving sweeps unscoped.
+gboolean proc_scanner_set_scope(ProcScanner* self, const gchar* cgroup_dir);
+
+// Re-reads one process, e.g. after it exec'd or renamed itself.
+void proc_scanner_refresh(ProcScanner* self, gint pid);
+
+// Returns TRUE if |pid| is still the process that started at |start_time|.
+gboolean proc_scanner_is_same_process(ProcScanner* self,
+                                      gint pid,
+                                      guint64 start_time);
+
+// Reads /proc/<pid>/<name> into |buffer| with one openat() and read().
+// Returns the number of bytes read, or -1 with errno set.
+gssize proc_scanner_read_file(ProcScanner* self,
+                              gint pid,
+                              const gchar* name,
+                              gchar* buffer,
+                              gsize size);
+
+// Opens /proc/<pid>/<name> with |flags|. Returns the fd, or -1 with errno
+// set.
+int proc_scanner_open(ProcScanner* self,
+                      gint pid,
+                      const gchar* name,
+                      int flags);
+
+// Resolves the symlink /proc/<pid>/<name> (e.g. "exe") into |buffer|,
+// NUL-terminated. Returns FALSE with errno set on failure.
+gboolean proc_scanner_read_link(ProcScanner* self,
+                                gint pid,
+                                const gchar* name,
+                                gchar* buffer,
+                                gsize size);
+
+// Calls |func| for every cached process, e.g. to examine them all after a
+// setting changed.
+void proc_scanner_foreach(ProcScanner* self,
+                          ProcScanFunc func,
+                          gpointer user_data);
+
+// Drops one process, e.g. after it exited.
+void proc_scanner_forget(ProcScanner* self, gint pid);
+
+// Drops the whole cache without reporting.
+void proc_scanner_clear(ProcScanner* self);
+
+G_END_DECLS
+
+#endif  // PROC_SCANNER_H_
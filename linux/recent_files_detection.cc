@@ -0,0 +1,278 @@
+#include "recent_files_detection.h"
+
+#include <gio/gio.h>
+
+#include <string.h>
+
+// 64-bit FNV-1a, used for the parsed-prefix fingerprint and for the
+// per-bookmark fingerprints.
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static const gchar kBookmarkOpen[] = "<bookmark ";
+static const gchar kBookmarkClose[] = "</bookmark>";
+
+typedef struct {
+  const gchar* application;  // <bookmark:application name="...">
+  const gchar* source_app;   // Reported to Dart as ScreenshotSnapshot.sourceApp
+} ScreenshotApplication;
+
+static const ScreenshotApplication kScreenshotApplications[] = {
+    {"gnome-screenshot", "GNOME Screenshot"},
+    {"org.gnome.Screenshot", "GNOME Screenshot"},
+    {"gnome-shell", "GNOME Screenshot"},
+    {"spectacle", "KDE Spectacle"},
+    {"org.kde.spectacle", "KDE Spectacle"},
+    {"flameshot", "Flameshot"},
+    {"shutter", "Shutter"},
+    {"ksnip", "ksnip"},
+    {"xfce4-screenshooter", "Xfce Screenshooter"},
+    {NULL, NULL},
+};
+
+struct _RecentFilesDetection {
+  RecentScreenshotCallback callback;
+  gpointer user_data;
+
+  gchar* file_path;
+  GFileMonitor* monitor;
+
+  // Everything before |parsed_offset| has already been examined, and
+  // |prefix_hash| fingerprints those bytes. GTK rewrites the file on every
+  // change but appends new bookmarks at the end, so while the prefix is
+  // unchanged only the bytes after it need to be looked at.
+  gsize parsed_offset;
+  guint64 prefix_hash;
+
+  // Fingerprints of the <bookmark> elements currently in the file.
+  GHashTable* known_entries;
+
+  // Bookmarks last touched before monitoring started are history.
+  gint64 start_time_ms;
+};
+
+static guint64 fnv1a(guint64 hash, const gchar* data, gsize len) {
+  for (gsize i = 0; i < len; i++) {
+    hash ^= (guchar)data[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// Returns a copy of the value of |name|="..." inside [start, end), with the
+// XML entities GBookmarkFile emits decoded.
+static gchar* get_attribute(const gchar* start,
+                            const gchar* end,
+                            const gchar* name) {
+  g_autofree gchar* needle = g_strdup_printf(" %s=\"", name);
+  const gchar* value = g_strstr_len(start, end - start, needle);
+  if (value == NULL) return NULL;
+  value += strlen(needle);
+
+  const gchar* value_end = (const gchar*)memchr(value, '"', end - value);
+  if (value_end == NULL) return NULL;
+
+  GString* out = g_string_sized_new(value_end - value);
+  for (const gchar* p = value; p < value_end; p++) {
+    if (*p == '&') {
+      static const struct {
+        const gchar* entity;
+        gchar c;
+      } kEntities[] = {{"&amp;", '&'},  {"&lt;", '<'},   {"&gt;", '>'},
+                       {"&quot;", '"'}, {"&apos;", '\''}};
+      gboolean decoded = FALSE;
+      for (gsize i = 0; i < G_N_ELEMENTS(kEntities); i++) {
+        gsize len = strlen(kEntities[i].entity);
+        if ((gsize)(value_end - p) >= len &&
+            strncmp(p, kEntities[i].entity, len) == 0) {
+          g_string_append_c(out, kEntities[i].c);
+          p += len - 1;
+          decoded = TRUE;
+          break;
+        }
+      }
+      if (decoded) continue;
+    }
+    g_string_append_c(out, *p);
+  }
+  return g_string_free(out, FALSE);
+}
+
+static gint64 parse_iso8601_ms(const gchar* value) {
+  if (value == NULL) return 0;
+  GDateTime* date_time = g_date_time_new_from_iso8601(value, NULL);
+  if (date_time == NULL) return 0;
+  gint64 ms = g_date_time_to_unix(date_time) * 1000 +
+              g_date_time_get_microsecond(date_time) / 1000;
+  g_date_time_unref(date_time);
+  return ms;
+}
+
+// Examines one <bookmark>...</bookmark> element. Elements whose fingerprint
+// is already known are skipped without further parsing; new or changed
+// image bookmarks registered by a screenshot tool are reported.
+static void examine_bookmark(RecentFilesDetection* self,
+                             const gchar* start,
+                             const gchar* end,
+                             GHashTable* seen,
+                             gboolean notify) {
+  guint64 fingerprint = fnv1a(FNV_OFFSET_BASIS, start, end - start);
+  gpointer key = (gpointer)(guintptr)fingerprint;
+  gboolean is_known = g_hash_table_contains(self->known_entries, key);
+  g_hash_table_add(seen, key);
+  if (is_known || !notify || self->callback == NULL) return;
+
+  if (g_strstr_len(start, end - start, "type=\"image/") == NULL) return;
+
+  const ScreenshotApplication* app = NULL;
+  const gchar* app_tag = NULL;
+  for (int i = 0; kScreenshotApplications[i].application != NULL; i++) {
+    g_autofree gchar* needle = g_strdup_printf(
+        "<bookmark:application name=\"%s\"",
+        kScreenshotApplications[i].application);
+    app_tag = g_strstr_len(start, end - start, needle);
+    if (app_tag != NULL) {
+      app = &kScreenshotApplications[i];
+      break;
+    }
+  }
+  if (app == NULL) return;
+
+  // Prefer the application's own registration time over the bookmark's.
+  const gchar* app_tag_end = (const gchar*)memchr(app_tag, '>', end - app_tag);
+  g_autofree gchar* app_modified =
+      get_attribute(app_tag, app_tag_end ? app_tag_end : end, "modified");
+  gint64 timestamp_ms = parse_iso8601_ms(app_modified);
+  if (timestamp_ms <= 0) {
+    const gchar* tag_end = (const gchar*)memchr(start, '>', end - start);
+    g_autofree gchar* modified =
+        get_attribute(start, tag_end ? tag_end : end, "modified");
+    timestamp_ms = parse_iso8601_ms(modified);
+  }
+  if (timestamp_ms < self->start_time_ms) return;
+
+  g_autofree gchar* href = get_attribute(start, end, "href");
+  if (href == NULL) return;
+  g_autofree gchar* path = g_filename_from_uri(href, NULL, NULL);
+  if (path == NULL) return;
+
+  self->callback(path, timestamp_ms, app->source_app, self->user_data);
+}
+
+static void reset_parse_state(RecentFilesDetection* self) {
+  self->parsed_offset = 0;
+  self->prefix_hash = FNV_OFFSET_BASIS;
+  g_hash_table_remove_all(self->known_entries);
+}
+
+static void parse_bookmarks(RecentFilesDetection* self, gboolean notify) {
+  g_autoptr(GError) error = NULL;
+  GMappedFile* mapped = g_mapped_file_new(self->file_path, FALSE, &error);
+  if (mapped == NULL) {
+    reset_parse_state(self);
+    return;
+  }
+
+  const gchar* contents = g_mapped_file_get_contents(mapped);
+  gsize length = g_mapped_file_get_length(mapped);
+
+  gsize offset = 0;
+  guint64 hash = FNV_OFFSET_BASIS;
+  GHashTable* seen = NULL;
+  if (self->parsed_offset > 0 && self->parsed_offset <= length &&
+      fnv1a(FNV_OFFSET_BASIS, contents, self->parsed_offset) ==
+          self->prefix_hash) {
+    // Prefix unchanged — only bookmarks appended since the last parse.
+    offset = self->parsed_offset;
+    hash = self->prefix_hash;
+    seen = g_hash_table_ref(self->known_entries);
+  } else {
+    // Something before the old offset changed (an entry was updated or
+    // removed). Walk every element, but only fingerprint the known ones,
+    // and rebuild the set so removed entries do not accumulate.
+    seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+  }
+
+  const gchar* limit = contents + length;
+  const gchar* p = contents + offset;
+  while (p < limit) {
+    const gchar* start = g_strstr_len(p, limit - p, kBookmarkOpen);
+    if (start == NULL) break;
+    const gchar* close = g_strstr_len(start, limit - start, kBookmarkClose);
+    if (close == NULL) break;  // Truncated — picked up on the next change.
+    const gchar* end = close + strlen(kBookmarkClose);
+    examine_bookmark(self, start, end, seen, notify);
+    p = end;
+  }
+
+  gsize consumed = p - contents;
+  self->prefix_hash = fnv1a(hash, contents + offset, consumed - offset);
+  self->parsed_offset = consumed;
+  g_hash_table_unref(self->known_entries);
+  self->known_entries = seen;
+
+  g_mapped_file_unref(mapped);
+}
+
+static void on_bookmarks_changed(GFileMonitor* monitor,
+                                 GFile* file,
+                                 GFile* other_file,
+                                 GFileMonitorEvent event_type,
+                                 gpointer user_data) {
+  // GTK replaces the file atomically (reported as CREATED); in-place
+  // writers finish with CHANGES_DONE_HINT.
+  if (event_type != G_FILE_MONITOR_EVENT_CREATED &&
+      event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
+    return;
+  }
+  parse_bookmarks((RecentFilesDetection*)user_data, TRUE);
+}
+
+RecentFilesDetection* recent_files_detection_new(RecentScreenshotCallback cb,
+                                                 gpointer user_data) {
+  RecentFilesDetection* self = g_new0(RecentFilesDetection, 1);
+  self->callback = cb;
+  self->user_data = user_data;
+  self->file_path = g_build_filename(g_get_user_data_dir(),
+                                     "recently-used.xbel", NULL);
+  self->known_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+  reset_parse_state(self);
+  return self;
+}
+
+void recent_files_detection_free(RecentFilesDetection* self) {
+  if (self == NULL) return;
+  recent_files_detection_stop(self);
+  g_hash_table_unref(self->known_entries);
+  g_free(self->file_path);
+  g_free(self);
+}
+
+void recent_files_detection_start(RecentFilesDetection* self) {
+  if (self->monitor != NULL) return;  // Already started.
+
+  g_autoptr(GFile) file = g_file_new_for_path(self->file_path);
+  g_autoptr(GError) error = NULL;
+  self->monitor =
+      g_file_monitor_file(file, G_FILE_MONITOR_NONE, NULL, &error);
+  if (self->monitor == NULL) {
+    g_warning("no_screenshot: failed to monitor %s: %s", self->file_path,
+              error->message);
+    return;
+  }
+  g_signal_connect(self->monitor, "changed",
+                   G_CALLBACK(on_bookmarks_changed), self);
+
+  // Baseline pass — existing bookmarks are history, not new captures.
+  self->start_time_ms = g_get_real_time() / 1000;
+  parse_bookmarks(self, FALSE);
+  g_message("no_screenshot: monitoring %s", self->file_path);
+}
+
+void recent_files_detection_stop(RecentFilesDetection* self) {
+  if (self->monitor != NULL) {
+    g_file_monitor_cancel(self->monitor);
+    g_clear_object(&self->monitor);
+  }
+  reset_parse_state(self);
+}
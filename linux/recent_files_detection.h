@@ -0,0 +1,27 @@
+#ifndef RECENT_FILES_DETECTION_H_
+#define RECENT_FILES_DETECTION_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Watches $XDG_DATA_HOME/recently-used.xbel, where most desktop screenshot
+// tools register the files they save — wherever they save them.
+typedef struct _RecentFilesDetection RecentFilesDetection;
+
+// Callback invoked when a screenshot tool registers a new image bookmark.
+typedef void (*RecentScreenshotCallback)(const gchar* file_path,
+                                         gint64 timestamp_ms,
+                                         const gchar* source_app,
+                                         gpointer user_data);
+
+RecentFilesDetection* recent_files_detection_new(RecentScreenshotCallback cb,
+                                                 gpointer user_data);
+void recent_files_detection_free(RecentFilesDetection* self);
+
+void recent_files_detection_start(RecentFilesDetection* self);
+void recent_files_detection_stop(RecentFilesDetection* self);
+
+G_END_DECLS
+
+#endif  // RECENT_FILES_DETECTION_H_
@@ -0,0 +1,28 @@
+#include "recorder_catalog.h"
+
+#include "recorder_catalog_index.h"
+
+static constexpr KnownRecorder kKnownRecorders[] = {
+    {"ffmpeg", FALSE, TRUE},
+    {"obs", FALSE, FALSE},
+    {"simplescreenrecorder", FALSE, FALSE},
+    {"kazam", TRUE, FALSE},
+    {"peek", FALSE, FALSE},
+    {"recordmydesktop", FALSE, FALSE},
+    {"vokoscreen", FALSE, FALSE},
+    {"vokoscreenNG", FALSE, FALSE},
+    {"gtk-recordmydesktop", TRUE, FALSE},
+    {"wf-recorder", FALSE, FALSE},
+    {"wl-screenrec", FALSE, FALSE},
+    {"gpu-screen-recorder", FALSE, FALSE},
+    {"kooha", FALSE, FALSE},
+    {"blue-recorder", FALSE, FALSE},
+    {"byzanz-record", FALSE, FALSE},
+};
+
+static constexpr CatalogIndex<G_N_ELEMENTS(kKnownRecorders)> kIndex =
+    catalog_index_build(kKnownRecorders);
+
+const KnownRecorder* recorder_catalog_match_comm(const gchar* comm) {
+  return catalog_index_match(kIndex, kKnownRecorders, comm);
+}
@@ -0,0 +1,25 @@
+#ifndef RECORDER_CATALOG_H_
+#define RECORDER_CATALOG_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// A known screen recorder.
+typedef struct {
+  const gchar* name;   // Executable base name (script name if |is_script|).
+  gboolean is_script;  // Runs under an interpreter; matched on argv instead.
+  // A general-purpose tool that only counts while its arguments capture the
+  // screen (see capture_args.h).
+  gboolean needs_capture_input;
+} KnownRecorder;
+
+// Returns the recorder whose name |comm| (from /proc/<pid>/comm or stat)
+// denotes — an exact match, or the first 15 characters of a longer name as
+// the kernel truncates it — or NULL. Runs for every scanned process, so it
+// compares against precomputed 16-byte signatures.
+const KnownRecorder* recorder_catalog_match_comm(const gchar* comm);
+
+G_END_DECLS
+
+#endif  // RECORDER_CATALOG_H_
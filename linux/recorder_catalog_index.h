@@ -0,0 +1,100 @@
+#ifndef RECORDER_CATALOG_INDEX_H_
+#define RECORDER_CATALOG_INDEX_H_
+
+#include <string.h>
+
+#include "recorder_catalog.h"
+
+// The lookup structure behind recorder_catalog_match_comm(), over a catalog
+// of any size so tests can also index generated catalogs.
+
+// TASK_COMM_LEN: 15 characters plus the terminating NUL.
+#define CATALOG_SIGNATURE_SIZE 16
+
+// Signatures are grouped into buckets by their first two bytes, so a comm is
+// only compared against the few names that share its bucket however large
+// the catalog grows. With at most a handful of candidates, SSE2 and AVX2
+// compares measured no faster than two 64-bit ones, even at 300 signatures.
+#define CATALOG_BUCKET_COUNT 256
+
+// The catalog, sorted by bucket, as 16-byte signatures with masks: a comm
+// matches entry i when (comm & masks[i]) == bytes[i]. The masks cover the
+// name and its terminating NUL.
+template <size_t N>
+struct CatalogIndex {
+  alignas(16) guchar bytes[N][CATALOG_SIGNATURE_SIZE];
+  alignas(16) guchar masks[N][CATALOG_SIGNATURE_SIZE];
+  guint16 recorder[N];  // Index into the catalog.
+  guint16 bucket_start[CATALOG_BUCKET_COUNT + 1];
+};
+
+constexpr guint catalog_bucket_of(guchar first, guchar second) {
+  return (first * 31u + second) % CATALOG_BUCKET_COUNT;
+}
+
+template <size_t N>
+constexpr CatalogIndex<N> catalog_index_build(
+    const KnownRecorder (&recorders)[N]) {
+  CatalogIndex<N> index{};
+
+  // Counting sort by bucket.
+  guint buckets[N] = {};
+  for (size_t i = 0; i < N; i++) {
+    const gchar* name = recorders[i].name;
+    buckets[i] = catalog_bucket_of((guchar)name[0],
+                                   name[0] != '\0' ? (guchar)name[1] : 0);
+    index.bucket_start[buckets[i] + 1]++;
+  }
+  for (size_t b = 0; b < CATALOG_BUCKET_COUNT; b++) {
+    index.bucket_start[b + 1] += index.bucket_start[b];
+  }
+
+  guint16 next[CATALOG_BUCKET_COUNT] = {};
+  for (size_t b = 0; b < CATALOG_BUCKET_COUNT; b++) {
+    next[b] = index.bucket_start[b];
+  }
+  for (size_t i = 0; i < N; i++) {
+    guint16 slot = next[buckets[i]]++;
+    index.recorder[slot] = (guint16)i;
+
+    const gchar* name = recorders[i].name;
+    size_t len = 0;
+    while (len < CATALOG_SIGNATURE_SIZE - 1 && name[len] != '\0') {
+      index.bytes[slot][len] = (guchar)name[len];
+      index.masks[slot][len] = 0xFF;
+      len++;
+    }
+    index.masks[slot][len] = 0xFF;  // The NUL after the (truncated) name.
+  }
+  return index;
+}
+
+// Returns the recorder of |recorders|, indexed as |index|, that |comm|
+// denotes, or NULL.
+template <size_t N>
+const KnownRecorder* catalog_index_match(const CatalogIndex<N>& index,
+                                         const KnownRecorder (&recorders)[N],
+                                         const gchar* comm) {
+  // Zero-padded, so anything past the name compares as NUL.
+  guchar key[CATALOG_SIGNATURE_SIZE] = {0};
+  size_t len = strnlen(comm, CATALOG_SIGNATURE_SIZE);
+  if (len == CATALOG_SIGNATURE_SIZE) return NULL;  // Longer than any comm.
+  memcpy(key, comm, len);
+
+  guint bucket = catalog_bucket_of(key[0], key[1]);
+  guint64 k[2];
+  memcpy(k, key, sizeof(k));
+  for (guint i = index.bucket_start[bucket];
+       i < index.bucket_start[bucket + 1]; i++) {
+    guint64 b[2];
+    guint64 m[2];
+    memcpy(b, index.bytes[i], sizeof(b));
+    memcpy(m, index.masks[i], sizeof(m));
+    if ((k[0] & m[0]) == b[0] && (k[1] & m[1]) == b[1]) {
+      return &recorders[index.recorder[i]];
+    }
+  }
+  return NULL;
+}
+
+#endif  // RECORDER_CATALOG_INDEX_H_
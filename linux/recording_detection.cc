@@ -1,96 +1,593 @@
 #include "recording_detection.h"
 
-#include <dirent.h>
-#include <stdio.h>
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <limits.h>
 #include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capture_args.h"
+#include "cgroup_scope.h"
+#include "deep_scan.h"
+#include "loopback_monitor.h"
+#include "pipewire_monitor.h"
+#include "poll_scheduler.h"
+#include "proc_events.h"
+#include "proc_scanner.h"
+#include "recorder_catalog.h"
+#include "screencast_monitor.h"
+#include "shm_segments.h"
+
+// A sweep that finds this many new or renamed processes (e.g. an app
+// launching) keeps polling at the fastest rate.
+#define PROCESS_BURST_THRESHOLD 4
+
+// Reported for a screencast until the app that started it is known.
+#define UNNAMED_SCREENCAST "screencast"
+
+// Key prefix of processes attached to a screen-sized shm segment.
+#define SHM_KEY_PREFIX "shm:"
 
-#define POLL_INTERVAL_SECONDS 2
-
-static const gchar* const kKnownRecordingProcessNames[] = {
-    "ffmpeg",
-    "obs",
-    "simplescreenrecorder",
-    "kazam",
-    "peek",
-    "recordmydesktop",
-    "vokoscreen",
-    "gtk-recordmydesktop",
+// The X server and compositors attach screen-sized segments themselves.
+static const gchar* const kDisplayServers[] = {
+    "Xorg",
+    "Xwayland",
+    "X",
+    "gnome-shell",
+    "kwin_x11",
+    "kwin_wayland",
+    "mutter",
+    "muffin",
+    "cinnamon",
+    "marco",
+    "xfwm4",
+    "picom",
+    "compton",
+    "compiz",
     NULL,
 };
 
+// Verification result for one process, valid while its start time matches.
+typedef struct {
+  guint64 start_time;
+  const KnownRecorder* candidate;  // What its comm matched.
+  gboolean is_verified;
+} VerifiedProcess;
+
+// A portal screencast or PipeWire capture stream; the app is not a
+// recorder process of its own.
+typedef struct {
+  gchar* name;
+  gint pid;  // 0 when unknown.
+  gint64 start_time_ms;
+} ScreenCast;
+
+typedef struct _Recorder Recorder;
+
 struct _RecordingDetection {
   RecordingStateChangedCallback callback;
   gpointer user_data;
 
-  guint poll_timer_id;
+  gboolean is_started;
+  PollScheduler* poll_scheduler;
+  guint sweep_changes;  // Processes reported by the current sweep.
   gboolean is_recording;
   gchar detected_process[256];
+
+  // Running recorders (pid → Recorder*), kept up to date from the
+  // incremental scanner — swept every poll, or fed by process events when
+  // available.
+  ProcScanner* scanner;
+  ProcEvents* proc_events;
+  gboolean is_event_driven;
+  GHashTable* recorders;
+  gboolean recorders_changed;
+
+  // Portal screencasts, PipeWire capture streams, virtual camera holders
+  // and shm grabbers (session path, "pipewire:<node id>", "v4l2:<pid>" or
+  // "shm:<pid>" → ScreenCast*), e.g. browser screen sharing or Wayland
+  // recorders, which need no recorder process.
+  ScreenCastMonitor* screencast_monitor;
+  PipeWireMonitor* pipewire_monitor;
+  LoopbackMonitor* loopback_monitor;
+  ShmSegments* shm_segments;
+  GHashTable* screencasts;
+
+  // Executable checks of comm matches (pid → VerifiedProcess*).
+  GHashTable* verified;
+
+  // Optional: new and changed processes that match no known recorder are
+  // examined for capture capability in the background, and every poll
+  // checks for screen-sized shm segments.
+  DeepScan* deep_scan;
+  gboolean is_deep_scan_enabled;
+
+  // Converts /proc start times (clock ticks after boot) to wall time.
+  gint64 boot_time_ms;
+  glong ticks_per_second;
 };
 
-static gboolean is_known_recording_process(const gchar* comm) {
-  for (int i = 0; kKnownRecordingProcessNames[i] != NULL; i++) {
-    // Use prefix match because /proc/PID/comm truncates names to 15 chars
-    // (e.g. "simplescreenrecorder" becomes "simplescreenrec").
-    if (g_str_has_prefix(comm, kKnownRecordingProcessNames[i]) ||
-        g_str_has_prefix(kKnownRecordingProcessNames[i], comm)) {
-      return TRUE;
-    }
+struct _Recorder {
+  RecordingDetection* detection;
+  gint pid;
+  guint64 start_time;
+  gchar* name;
+  gboolean is_deep_scanned;  // Found by the deep scan, not by name.
+
+  // When polling, exits are noticed through a pidfd rather than by
+  // rescanning /proc. -1 if pidfds are unsupported (Linux < 5.3).
+  int pidfd;
+  guint exit_watch_id;
+};
+
+static void recorder_free(gpointer data) {
+  Recorder* recorder = (Recorder*)data;
+  if (recorder->exit_watch_id != 0) g_source_remove(recorder->exit_watch_id);
+  if (recorder->pidfd >= 0) close(recorder->pidfd);
+  g_free(recorder->name);
+  g_free(recorder);
+}
+
+static void screencast_free(gpointer data) {
+  ScreenCast* screencast = (ScreenCast*)data;
+  g_free(screencast->name);
+  g_free(screencast);
+}
+
+static const gchar* path_basename(const gchar* path) {
+  const gchar* slash = strrchr(path, '/');
+  return slash != NULL ? slash + 1 : path;
+}
+
+// Second stage, on candidates only: the executable (or, for interpreted
+// recorders, the script in argv) must carry the recorder's full name, so a
+// process cannot pass by renaming its comm.
+static gboolean verify_executable(RecordingDetection* self,
+                                  gint pid,
+                                  const gchar* comm,
+                                  const KnownRecorder* candidate) {
+  gchar exe[PATH_MAX];
+  if (!proc_scanner_read_link(self->scanner, pid, "exe", exe, sizeof(exe))) {
+    // Other users' processes cannot be inspected; trust an exact comm.
+    return errno == EACCES && strcmp(comm, candidate->name) == 0;
+  }
+  // A binary replaced by an upgrade while running.
+  if (g_str_has_suffix(exe, " (deleted)")) {
+    exe[strlen(exe) - strlen(" (deleted)")] = '\0';
+  }
+  if (!candidate->is_script) {
+    return strcmp(path_basename(exe), candidate->name) == 0;
+  }
+
+  // "python3 /usr/bin/kazam ..." — the script is one of the first arguments.
+  gchar cmdline[1024];
+  gssize n = proc_scanner_read_file(self->scanner, pid, "cmdline", cmdline,
+                                    sizeof(cmdline) - 1);
+  if (n <= 0) return FALSE;
+  cmdline[n] = '\0';
+  const gchar* arg = cmdline;
+  for (int i = 0; i < 3 && arg < cmdline + n; i++) {
+    if (strcmp(path_basename(arg), candidate->name) == 0) return TRUE;
+    arg += strlen(arg) + 1;
   }
   return FALSE;
 }
 
-static gboolean check_recording_processes(gpointer user_data) {
-  RecordingDetection* self = (RecordingDetection*)user_data;
+// Third stage, for general-purpose tools only: the arguments must capture
+// the screen — an ffmpeg transcode is not a recording. Unreadable arguments
+// do not count, nor do relative inputs if the working directory is.
+static gboolean verify_capture_input(RecordingDetection* self, gint pid) {
+  gchar cmdline[4096];
+  gssize n = proc_scanner_read_file(self->scanner, pid, "cmdline", cmdline,
+                                    sizeof(cmdline) - 1);
+  if (n <= 0) return FALSE;
+  cmdline[n] = '\0';
+  gchar cwd[PATH_MAX];
+  gboolean has_cwd =
+      proc_scanner_read_link(self->scanner, pid, "cwd", cwd, sizeof(cwd));
+  return capture_args_is_screen_capture(cmdline, (gsize)n,
+                                        has_cwd ? cwd : NULL);
+}
 
-  gboolean found = FALSE;
-  gchar matched_name[256] = {0};
-  DIR* proc_dir = opendir("/proc");
-  if (proc_dir == NULL) return G_SOURCE_CONTINUE;
+// Returns the recorder |pid| is, or NULL. Executable checks are cached by
+// (pid, start time), so each candidate process is verified once.
+static const KnownRecorder* identify_recorder(RecordingDetection* self,
+                                              gint pid,
+                                              guint64 start_time,
+                                              const gchar* comm) {
+  // First stage, on every process: the comm signature.
+  const KnownRecorder* candidate = recorder_catalog_match_comm(comm);
+  if (candidate == NULL) return NULL;
 
-  struct dirent* entry;
-  while ((entry = readdir(proc_dir)) != NULL) {
-    // Only consider numeric directories (PIDs).
-    if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+  gpointer key = GINT_TO_POINTER(pid);
+  VerifiedProcess* verified =
+      (VerifiedProcess*)g_hash_table_lookup(self->verified, key);
+  if (verified == NULL || verified->start_time != start_time ||
+      verified->candidate != candidate) {
+    verified = g_new0(VerifiedProcess, 1);
+    verified->start_time = start_time;
+    verified->candidate = candidate;
+    verified->is_verified =
+        verify_executable(self, pid, comm, candidate) &&
+        (!candidate->needs_capture_input || verify_capture_input(self, pid));
+    g_hash_table_replace(self->verified, key, verified);
+  }
+  return verified->is_verified ? candidate : NULL;
+}
 
-    gchar comm_path[256];
-    g_snprintf(comm_path, sizeof(comm_path), "/proc/%s/comm", entry->d_name);
+static void update_recording_state(RecordingDetection* self);
 
-    FILE* fp = fopen(comm_path, "r");
-    if (fp == NULL) continue;
+static void set_screencast(RecordingDetection* self,
+                           const gchar* key,
+                           const gchar* app_name,
+                           gint pid,
+                           gboolean is_active) {
+  if (!is_active) {
+    g_hash_table_remove(self->screencasts, key);
+  } else {
+    ScreenCast* screencast =
+        (ScreenCast*)g_hash_table_lookup(self->screencasts, key);
+    if (screencast == NULL) {
+      screencast = g_new0(ScreenCast, 1);
+      screencast->start_time_ms = g_get_real_time() / 1000;
+      g_hash_table_insert(self->screencasts, g_strdup(key), screencast);
+    }
+    g_free(screencast->name);
+    screencast->name = g_strdup(app_name != NULL && app_name[0] != '\0'
+                                    ? app_name
+                                    : UNNAMED_SCREENCAST);
+    screencast->pid = pid;
+  }
+  self->recorders_changed = TRUE;
+  update_recording_state(self);
+}
 
-    gchar comm[256];
-    if (fgets(comm, sizeof(comm), fp) != NULL) {
-      // Strip trailing newline.
-      gsize len = strlen(comm);
-      if (len > 0 && comm[len - 1] == '\n') comm[len - 1] = '\0';
-
-      if (is_known_recording_process(comm)) {
-        found = TRUE;
-        g_strlcpy(matched_name, comm, sizeof(matched_name));
-        fclose(fp);
-        break;
-      }
+static void on_screencast_changed(const gchar* session,
+                                  const gchar* app_name,
+                                  gboolean is_active,
+                                  gpointer user_data) {
+  set_screencast((RecordingDetection*)user_data, session, app_name, 0,
+                 is_active);
+}
+
+static void on_capture_changed(guint32 node_id,
+                               const gchar* app_name,
+                               gint pid,
+                               gboolean is_active,
+                               gpointer user_data) {
+  g_autofree gchar* key = g_strdup_printf("pipewire:%u", node_id);
+  set_screencast((RecordingDetection*)user_data, key, app_name, pid,
+                 is_active);
+}
+
+static void on_loopback_holder_changed(gint pid,
+                                       const gchar* app_name,
+                                       gboolean is_holding,
+                                       gpointer user_data) {
+  g_autofree gchar* key = g_strdup_printf("v4l2:%d", pid);
+  set_screencast((RecordingDetection*)user_data, key, app_name, pid,
+                 is_holding);
+}
+
+static gboolean on_recorder_exited(gint fd,
+                                   GIOCondition condition,
+                                   gpointer user_data) {
+  Recorder* recorder = (Recorder*)user_data;
+  RecordingDetection* self = recorder->detection;
+  gint pid = recorder->pid;
+
+  recorder->exit_watch_id = 0;  // Removed by returning G_SOURCE_REMOVE.
+  g_hash_table_remove(self->recorders, GINT_TO_POINTER(pid));
+  self->recorders_changed = TRUE;
+  proc_scanner_forget(self->scanner, pid);
+
+  update_recording_state(self);
+  return G_SOURCE_REMOVE;
+}
+
+// Returns FALSE if the PID no longer belongs to the recorder.
+static gboolean watch_recorder_exit(RecordingDetection* self,
+                                    Recorder* recorder) {
+  int pidfd = (int)syscall(SYS_pidfd_open, recorder->pid, 0);
+  if (pidfd < 0) return TRUE;  // Exit is noticed by the next sweep instead.
+
+  // The PID may have been reused between the sweep and pidfd_open().
+  if (!proc_scanner_is_same_process(self->scanner, recorder->pid,
+                                    recorder->start_time)) {
+    close(pidfd);
+    return FALSE;
+  }
+
+  recorder->pidfd = pidfd;
+  recorder->exit_watch_id =
+      g_unix_fd_add(pidfd, G_IO_IN, on_recorder_exited, recorder);
+  return TRUE;
+}
+
+static void add_recorder(RecordingDetection* self,
+                         gint pid,
+                         guint64 start_time,
+                         const gchar* name,
+                         gboolean is_deep_scanned);
+
+// Keeps |recorders| in sync with the scanner's view of the process list.
+static void on_process_changed(gint pid,
+                               guint64 start_time,
+                               const gchar* comm,
+                               gpointer user_data) {
+  RecordingDetection* self = (RecordingDetection*)user_data;
+  gpointer key = GINT_TO_POINTER(pid);
+  if (comm == NULL) {
+    g_hash_table_remove(self->verified, key);
+  } else {
+    self->sweep_changes++;
+  }
+
+  const KnownRecorder* known =
+      comm != NULL ? identify_recorder(self, pid, start_time, comm) : NULL;
+  if (known != NULL) {
+    add_recorder(self, pid, start_time, known->name, FALSE);
+    return;
+  }
+
+  Recorder* existing = (Recorder*)g_hash_table_lookup(self->recorders, key);
+  if (comm != NULL && self->is_deep_scan_enabled) {
+    deep_scan_queue(self->deep_scan, pid, start_time, comm);
+    // A deep-scanned recorder that renamed itself stays until rescanned.
+    if (existing != NULL && existing->is_deep_scanned &&
+        existing->start_time == start_time) {
+      return;
     }
-    fclose(fp);
-  }
-  closedir(proc_dir);
-
-  // Fire callback only on state transitions.
-  if (found != self->is_recording) {
-    self->is_recording = found;
-    if (found) {
-      g_strlcpy(self->detected_process, matched_name,
-                 sizeof(self->detected_process));
-    } else {
-      self->detected_process[0] = '\0';
+  } else if (comm == NULL) {
+    deep_scan_cancel(self->deep_scan, pid);
+  }
+  if (g_hash_table_remove(self->recorders, key)) {
+    self->recorders_changed = TRUE;
+  }
+}
+
+static void add_recorder(RecordingDetection* self,
+                         gint pid,
+                         guint64 start_time,
+                         const gchar* name,
+                         gboolean is_deep_scanned) {
+  gpointer key = GINT_TO_POINTER(pid);
+  Recorder* existing = (Recorder*)g_hash_table_lookup(self->recorders, key);
+  if (existing != NULL && existing->start_time == start_time) {
+    existing->is_deep_scanned = is_deep_scanned;
+    if (g_strcmp0(existing->name, name) != 0) {
+      g_free(existing->name);
+      existing->name = g_strdup(name);
+      self->recorders_changed = TRUE;
     }
-    if (self->callback != NULL) {
-      self->callback(self->is_recording, self->detected_process,
-                     self->user_data);
+    return;
+  }
+
+  Recorder* recorder = g_new0(Recorder, 1);
+  recorder->detection = self;
+  recorder->pid = pid;
+  recorder->start_time = start_time;
+  recorder->name = g_strdup(name);
+  recorder->is_deep_scanned = is_deep_scanned;
+  recorder->pidfd = -1;
+  // Process events already report exits.
+  self->recorders_changed = TRUE;
+  if (!self->is_event_driven && !watch_recorder_exit(self, recorder)) {
+    recorder_free(recorder);
+    g_hash_table_remove(self->recorders, key);
+    return;
+  }
+  g_hash_table_replace(self->recorders, key, recorder);
+}
+
+static void on_deep_scan_result(gint pid,
+                                guint64 start_time,
+                                const gchar* comm,
+                                gboolean is_capture,
+                                gpointer user_data) {
+  RecordingDetection* self = (RecordingDetection*)user_data;
+  // The PID may have been reused while the scan was queued.
+  if (!proc_scanner_is_same_process(self->scanner, pid, start_time)) return;
+
+  gpointer key = GINT_TO_POINTER(pid);
+  Recorder* existing = (Recorder*)g_hash_table_lookup(self->recorders, key);
+  if (is_capture) {
+    add_recorder(self, pid, start_time, comm, TRUE);
+  } else if (existing != NULL && existing->is_deep_scanned) {
+    g_hash_table_remove(self->recorders, key);
+    self->recorders_changed = TRUE;
+  }
+  update_recording_state(self);
+}
+
+// Queues every known process that is not a recorder already.
+static void queue_deep_scan(gint pid,
+                            guint64 start_time,
+                            const gchar* comm,
+                            gpointer user_data) {
+  RecordingDetection* self = (RecordingDetection*)user_data;
+  if (!g_hash_table_contains(self->recorders, GINT_TO_POINTER(pid))) {
+    deep_scan_queue(self->deep_scan, pid, start_time, comm);
+  }
+}
+
+static gboolean is_display_server(const gchar* comm) {
+  for (int i = 0; kDisplayServers[i] != NULL; i++) {
+    if (strcmp(comm, kDisplayServers[i]) == 0) return TRUE;
+  }
+  return FALSE;
+}
+
+static void on_screen_sized_segment(gint cpid, gint lpid, gpointer user_data) {
+  GHashTable* attached = (GHashTable*)user_data;
+  if (cpid > 0) g_hash_table_add(attached, GINT_TO_POINTER(cpid));
+  if (lpid > 0) g_hash_table_add(attached, GINT_TO_POINTER(lpid));
+}
+
+// Syncs the "shm:" screencasts with the processes attached to screen-sized
+// segments, skipping this process and the display server.
+static void check_shm_segments(RecordingDetection* self) {
+  GHashTable* attached = g_hash_table_new(g_direct_hash, g_direct_equal);
+  if (!shm_segments_scan(self->shm_segments, on_screen_sized_segment,
+                         attached)) {
+    g_hash_table_unref(attached);
+    return;
+  }
+  g_hash_table_remove(attached, GINT_TO_POINTER(getpid()));
+
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->screencasts);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (!g_str_has_prefix((const gchar*)key, SHM_KEY_PREFIX)) continue;
+    gint pid = ((const ScreenCast*)value)->pid;
+    // Still attached: already known, nothing to read.
+    if (g_hash_table_remove(attached, GINT_TO_POINTER(pid))) continue;
+    g_hash_table_iter_remove(&iter);
+    self->recorders_changed = TRUE;
+  }
+
+  g_hash_table_iter_init(&iter, attached);
+  while (g_hash_table_iter_next(&iter, &key, NULL)) {
+    gint pid = GPOINTER_TO_INT(key);
+    gchar comm[256];
+    gssize n = proc_scanner_read_file(self->scanner, pid, "comm", comm,
+                                      sizeof(comm) - 1);
+    if (n <= 0) continue;  // Gone, or the segment outlived its creator.
+    comm[n] = '\0';
+    g_strchomp(comm);
+    if (is_display_server(comm)) continue;
+
+    ScreenCast* screencast = g_new0(ScreenCast, 1);
+    screencast->name = g_strdup(comm);
+    screencast->pid = pid;
+    screencast->start_time_ms = g_get_real_time() / 1000;
+    g_hash_table_insert(self->screencasts,
+                        g_strdup_printf(SHM_KEY_PREFIX "%d", pid), screencast);
+    self->recorders_changed = TRUE;
+  }
+  g_hash_table_unref(attached);
+}
+
+static void clear_shm_segments(RecordingDetection* self) {
+  GHashTableIter iter;
+  gpointer key;
+  g_hash_table_iter_init(&iter, self->screencasts);
+  while (g_hash_table_iter_next(&iter, &key, NULL)) {
+    if (g_str_has_prefix((const gchar*)key, SHM_KEY_PREFIX)) {
+      g_hash_table_iter_remove(&iter);
+      self->recorders_changed = TRUE;
     }
   }
+}
+
+static gboolean is_shm_check_enabled(RecordingDetection* self) {
+  return self->is_deep_scan_enabled &&
+         shm_segments_has_sizes(self->shm_segments);
+}
+
+// Fires the callback when the recording state or the recorder set changed.
+// Scanner and event updates only flag changes, so this costs nothing when
+// the set is unchanged.
+static void update_recording_state(RecordingDetection* self) {
+  gboolean found = g_hash_table_size(self->recorders) > 0 ||
+                   g_hash_table_size(self->screencasts) > 0;
+  if (found == self->is_recording && !self->recorders_changed) return;
+
+  self->is_recording = found;
+  self->recorders_changed = FALSE;
+
+  // Report the newest recorder — the one most likely to have just started.
+  GPtrArray* recorders = recording_detection_get_recorders(self);
+  const ActiveRecorder* newest =
+      recorders->len > 0
+          ? (const ActiveRecorder*)g_ptr_array_index(recorders,
+                                                     recorders->len - 1)
+          : NULL;
+  g_strlcpy(self->detected_process, newest != NULL ? newest->name : "",
+            sizeof(self->detected_process));
+  g_ptr_array_unref(recorders);
+
+  if (self->callback != NULL) {
+    self->callback(self->is_recording, self->detected_process,
+                   self->user_data);
+  }
+}
 
-  return G_SOURCE_CONTINUE;
+// Returns TRUE if the sweep saw a burst of process activity or a recorder
+// come or go, so the scheduler keeps polling quickly.
+static gboolean check_recording_processes(gpointer user_data) {
+  RecordingDetection* self = (RecordingDetection*)user_data;
+  self->sweep_changes = 0;
+  // Process events keep the scanner current; then only the shm check polls.
+  if (!self->is_event_driven) proc_scanner_scan(self->scanner, FALSE);
+  if (is_shm_check_enabled(self)) check_shm_segments(self);
+  gboolean is_busy = self->recorders_changed ||
+                     self->sweep_changes >= PROCESS_BURST_THRESHOLD;
+  update_recording_state(self);
+  return is_busy;
+}
+
+static void start_polling(RecordingDetection* self) {
+  self->is_event_driven = FALSE;
+  // The first poll runs immediately.
+  poll_scheduler_start(self->poll_scheduler);
+}
+
+// With process events, polling is only needed for the shm check.
+static void update_event_driven_polling(RecordingDetection* self) {
+  if (!self->is_started || !self->is_event_driven) return;
+  if (is_shm_check_enabled(self)) {
+    poll_scheduler_start(self->poll_scheduler);
+  } else {
+    poll_scheduler_stop(self->poll_scheduler);
+    clear_shm_segments(self);
+  }
+}
+
+static void on_proc_event(ProcEventKind kind,
+                          gint pid,
+                          const gchar* comm,
+                          gpointer user_data) {
+  RecordingDetection* self = (RecordingDetection*)user_data;
+  switch (kind) {
+    case PROC_EVENTS_CONFIRMED:
+      // Polling kept the scanner current until now.
+      self->is_event_driven = TRUE;
+      update_event_driven_polling(self);
+      return;
+
+    case PROC_EVENTS_EXEC:
+      // A new program image keeps the PID and start time.
+      g_hash_table_remove(self->verified, GINT_TO_POINTER(pid));
+      proc_scanner_refresh(self->scanner, pid);
+      break;
+
+    case PROC_EVENTS_COMM:
+      proc_scanner_refresh(self->scanner, pid);
+      break;
+
+    case PROC_EVENTS_EXIT:
+      proc_scanner_forget(self->scanner, pid);
+      break;
+
+    case PROC_EVENTS_OVERRUN:
+      // Missed exec/rename events may affect any cached process.
+      g_hash_table_remove_all(self->verified);
+      proc_scanner_scan(self->scanner, TRUE);
+      break;
+
+    case PROC_EVENTS_FAILED:
+      proc_events_stop(self->proc_events);
+      start_polling(self);
+      return;
+  }
+
+  update_recording_state(self);
 }
 
 RecordingDetection* recording_detection_new(RecordingStateChangedCallback cb,
@@ -98,35 +595,218 @@ RecordingDetection* recording_detection_new(RecordingStateChangedCallback cb,
   RecordingDetection* self = g_new0(RecordingDetection, 1);
   self->callback = cb;
   self->user_data = user_data;
-  self->poll_timer_id = 0;
+  self->poll_scheduler =
+      poll_scheduler_new(NULL, check_recording_processes, self);
   self->is_recording = FALSE;
+  self->scanner = proc_scanner_new(NULL, on_process_changed, self);
+
+  struct timespec boot_time;
+  clock_gettime(CLOCK_BOOTTIME, &boot_time);
+  self->boot_time_ms = g_get_real_time() / 1000 -
+                       ((gint64)boot_time.tv_sec * 1000 +
+                        boot_time.tv_nsec / 1000000);
+  self->ticks_per_second = sysconf(_SC_CLK_TCK);
+  self->proc_events = proc_events_new(on_proc_event, self);
+  self->recorders = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                          NULL, recorder_free);
+  self->verified =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+  self->deep_scan = deep_scan_new(self->scanner, on_deep_scan_result, self);
+  self->screencast_monitor =
+      screencast_monitor_new(NULL, on_screencast_changed, self);
+  self->pipewire_monitor =
+      pipewire_monitor_new(NULL, on_capture_changed, self);
+  self->loopback_monitor =
+      loopback_monitor_new(on_loopback_holder_changed, self);
+  self->shm_segments = shm_segments_new(NULL);
+  self->screencasts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                            screencast_free);
   return self;
 }
 
 void recording_detection_free(RecordingDetection* self) {
   if (self == NULL) return;
   recording_detection_stop(self);
+  proc_events_free(self->proc_events);
+  screencast_monitor_free(self->screencast_monitor);
+  pipewire_monitor_free(self->pipewire_monitor);
+  loopback_monitor_free(self->loopback_monitor);
+  shm_segments_free(self->shm_segments);
+  g_hash_table_unref(self->screencasts);
+  deep_scan_free(self->deep_scan);
+  proc_scanner_free(self->scanner);
+  poll_scheduler_free(self->poll_scheduler);
+  g_hash_table_unref(self->recorders);
+  g_hash_table_unref(self->verified);
   g_free(self);
 }
 
 void recording_detection_start(RecordingDetection* self) {
-  if (self->poll_timer_id != 0) return;  // Already started.
+  if (self->is_started) return;
+  self->is_started = TRUE;
+  screencast_monitor_start(self->screencast_monitor);
+  pipewire_monitor_start(self->pipewire_monitor);
+  loopback_monitor_start(self->loopback_monitor);
 
-  // Do an initial check immediately.
-  check_recording_processes(self);
+  // Prefer process events; subscribe before the initial scan so nothing
+  // started in between is missed. An unconfirmed subscription may never
+  // deliver, so polling continues until PROC_EVENTS_CONFIRMED.
+  if (proc_events_start(self->proc_events) &&
+      proc_events_is_confirmed(self->proc_events)) {
+    self->is_event_driven = TRUE;
+    proc_scanner_scan(self->scanner, FALSE);
+    update_recording_state(self);
+    update_event_driven_polling(self);
+    return;
+  }
 
-  self->poll_timer_id =
-      g_timeout_add_seconds(POLL_INTERVAL_SECONDS, check_recording_processes, self);
+  start_polling(self);
 }
 
 void recording_detection_stop(RecordingDetection* self) {
-  if (self->poll_timer_id != 0) {
-    g_source_remove(self->poll_timer_id);
-    self->poll_timer_id = 0;
-  }
+  self->is_started = FALSE;
+  poll_scheduler_stop(self->poll_scheduler);
+  proc_events_stop(self->proc_events);
+  screencast_monitor_stop(self->screencast_monitor);
+  pipewire_monitor_stop(self->pipewire_monitor);
+  loopback_monitor_stop(self->loopback_monitor);
+  self->is_event_driven = FALSE;
+  deep_scan_clear(self->deep_scan);
+  proc_scanner_clear(self->scanner);
+  g_hash_table_remove_all(self->recorders);
+  g_hash_table_remove_all(self->verified);
+  g_hash_table_remove_all(self->screencasts);
+  self->recorders_changed = FALSE;
   self->is_recording = FALSE;
 }
 
+void recording_detection_set_poll_config(RecordingDetection* self,
+                                         const PollSchedulerConfig* config) {
+  poll_scheduler_set_config(self->poll_scheduler, config);
+}
+
+void recording_detection_set_attentive(RecordingDetection* self,
+                                       gboolean is_attentive) {
+  poll_scheduler_set_attentive(self->poll_scheduler, is_attentive);
+}
+
+void recording_detection_set_deep_scan(RecordingDetection* self,
+                                       gboolean is_enabled) {
+  if (self->is_deep_scan_enabled == is_enabled) return;
+  self->is_deep_scan_enabled = is_enabled;
+
+  update_event_driven_polling(self);
+  if (is_enabled) {
+    proc_scanner_foreach(self->scanner, queue_deep_scan, self);
+    if (!self->is_event_driven) poll_scheduler_trigger(self->poll_scheduler);
+    return;
+  }
+
+  deep_scan_clear(self->deep_scan);
+  clear_shm_segments(self);
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->recorders);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    if (((Recorder*)value)->is_deep_scanned) {
+      g_hash_table_iter_remove(&iter);
+      self->recorders_changed = TRUE;
+    }
+  }
+  update_recording_state(self);
+}
+
+void recording_detection_set_session_scope(RecordingDetection* self,
+                                           gboolean is_enabled) {
+  g_autofree gchar* slice =
+      is_enabled ? cgroup_scope_find_user_slice() : NULL;
+  if (is_enabled && slice == NULL) {
+    g_message("no_screenshot: no user session cgroup, scanning all of /proc");
+  }
+  if (!proc_scanner_set_scope(self->scanner, slice)) {
+    g_warning("no_screenshot: cannot open cgroup %s", slice);
+    return;
+  }
+  if (!self->is_started) return;
+
+  // Out-of-scope processes drop out (or in) with the next sweep.
+  if (self->is_event_driven) {
+    proc_scanner_scan(self->scanner, FALSE);
+    update_recording_state(self);
+  } else {
+    poll_scheduler_trigger(self->poll_scheduler);
+  }
+}
+
+void recording_detection_set_frame_sizes(RecordingDetection* self,
+                                         const guint64* sizes,
+                                         guint n_sizes) {
+  shm_segments_set_sizes(self->shm_segments, sizes, n_sizes);
+  if (!is_shm_check_enabled(self)) clear_shm_segments(self);
+  update_event_driven_polling(self);
+  update_recording_state(self);
+}
+
 gboolean recording_detection_is_recording(RecordingDetection* self) {
   return self->is_recording;
 }
+
+static void active_recorder_free(gpointer data) {
+  ActiveRecorder* recorder = (ActiveRecorder*)data;
+  g_free(recorder->name);
+  g_free(recorder);
+}
+
+static gint compare_active_recorders(gconstpointer a, gconstpointer b) {
+  const ActiveRecorder* ra = *(const ActiveRecorder* const*)a;
+  const ActiveRecorder* rb = *(const ActiveRecorder* const*)b;
+  if (ra->start_time_ms != rb->start_time_ms) {
+    return ra->start_time_ms < rb->start_time_ms ? -1 : 1;
+  }
+  return ra->pid - rb->pid;
+}
+
+GPtrArray* recording_detection_get_recorders(RecordingDetection* self) {
+  GPtrArray* result = g_ptr_array_new_with_free_func(active_recorder_free);
+
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->recorders);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    const Recorder* recorder = (const Recorder*)value;
+    ActiveRecorder* active = g_new0(ActiveRecorder, 1);
+    active->pid = recorder->pid;
+    active->name = g_strdup(recorder->name);
+    active->start_time_ms =
+        self->ticks_per_second > 0
+            ? self->boot_time_ms +
+                  (gint64)(recorder->start_time * 1000 /
+                           self->ticks_per_second)
+            : 0;
+    g_ptr_array_add(result, active);
+  }
+  // A recorder capturing through PipeWire (e.g. OBS on Wayland) is listed
+  // once, however many streams it has.
+  GHashTable* listed_pids = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_hash_table_iter_init(&iter, self->recorders);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    g_hash_table_add(listed_pids,
+                     GINT_TO_POINTER(((const Recorder*)value)->pid));
+  }
+  g_hash_table_iter_init(&iter, self->screencasts);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    const ScreenCast* screencast = (const ScreenCast*)value;
+    if (screencast->pid > 0 &&
+        !g_hash_table_add(listed_pids, GINT_TO_POINTER(screencast->pid))) {
+      continue;
+    }
+    ActiveRecorder* active = g_new0(ActiveRecorder, 1);
+    active->pid = screencast->pid;
+    active->name = g_strdup(screencast->name);
+    active->start_time_ms = screencast->start_time_ms;
+    g_ptr_array_add(result, active);
+  }
+  g_hash_table_unref(listed_pids);
+  g_ptr_array_sort(result, compare_active_recorders);
+  return result;
+}
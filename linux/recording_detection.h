@@ -3,11 +3,21 @@
 
 #include <glib.h>
 
+#include "poll_scheduler.h"
+
 G_BEGIN_DECLS
 
 typedef struct _RecordingDetection RecordingDetection;
 
-// Callback invoked when the recording state changes.
+// A running screen recorder, portal screencast or PipeWire capture stream.
+typedef struct {
+  gint pid;  // 0 when unknown, e.g. for portal screencasts.
+  gchar* name;
+  gint64 start_time_ms;  // Process start, ms since epoch.
+} ActiveRecorder;
+
+// Callback invoked when the recording state or the set of running recorders
+// changes. |process_name| is the most recently started recorder.
 typedef void (*RecordingStateChangedCallback)(gboolean is_recording,
                                               const gchar* process_name,
                                               gpointer user_data);
@@ -19,8 +29,41 @@ void recording_detection_free(RecordingDetection* self);
 void recording_detection_start(RecordingDetection* self);
 void recording_detection_stop(RecordingDetection* self);
 
+// Tunes the process polling used when process events are unavailable.
+void recording_detection_set_poll_config(RecordingDetection* self,
+                                         const PollSchedulerConfig* config);
+
+// Whether the user is looking at protected content (window focused and
+// visible, protection on). Polling is fastest while attentive and backs off
+// otherwise; becoming attentive polls immediately.
+void recording_detection_set_attentive(RecordingDetection* self,
+                                       gboolean is_attentive);
+
+// Also examines processes with unremarkable names for capture capability
+// (open capture devices, mapped capture libraries), and polls for processes
+// attached to screen-sized shared memory segments. Off by default; the work
+// is spread over short background ticks.
+void recording_detection_set_deep_scan(RecordingDetection* self,
+                                       gboolean is_enabled);
+
+// Limits process scanning to the user's login session cgroup (the systemd
+// user slice), which skips other users' processes and system services.
+// Without a user slice every process is scanned as before.
+void recording_detection_set_session_scope(RecordingDetection* self,
+                                           gboolean is_enabled);
+
+// Sets the byte sizes of a 32-bit frame of the screen and of each monitor,
+// which X11 grabbers allocate as MIT-SHM segments.
+void recording_detection_set_frame_sizes(RecordingDetection* self,
+                                         const guint64* sizes,
+                                         guint n_sizes);
+
 gboolean recording_detection_is_recording(RecordingDetection* self);
 
+// Returns the running recorders (ActiveRecorder*), oldest first. Free with
+// g_ptr_array_unref().
+GPtrArray* recording_detection_get_recorders(RecordingDetection* self);
+
 G_END_DECLS
 
 #endif  // RECORDING_DETECTION_H_
@@ -0,0 +1,464 @@
+#include "screencast_monitor.h"
+
+#include <gio/gio.h>
+
+#include <string.h>
+
+#define DBUS_NAME "org.freedesktop.DBus"
+#define DBUS_PATH "/org/freedesktop/DBus"
+#define SCREENCAST_INTERFACE "org.freedesktop.portal.ScreenCast"
+#define REQUEST_INTERFACE "org.freedesktop.portal.Request"
+#define SESSION_INTERFACE "org.freedesktop.portal.Session"
+#define REQUEST_PATH_PREFIX "/org/freedesktop/portal/desktop/request/"
+
+// Start calls whose Response never arrives are forgotten past this many.
+#define MAX_PENDING_STARTS 32
+
+// Only the messages that make up a screencast's lifetime are monitored;
+// NameOwnerChanged with an empty new owner reports clients that vanished
+// without closing their sessions.
+static const gchar* const kMonitorRules[] = {
+    "type='method_call',interface='" SCREENCAST_INTERFACE "',member='Start'",
+    "type='signal',interface='" REQUEST_INTERFACE "',member='Response'",
+    "type='signal',interface='" SESSION_INTERFACE "',member='Closed'",
+    "type='method_call',interface='" SESSION_INTERFACE "',member='Close'",
+    "type='signal',sender='" DBUS_NAME "',member='NameOwnerChanged',arg2=''",
+    NULL,
+};
+
+typedef struct {
+  gchar* sender;
+  gchar* session;
+  gchar* request;  // Expected request handle; NULL if no handle_token.
+} PendingStart;
+
+typedef struct {
+  gchar* sender;
+  gchar* app_name;
+} ActiveSession;
+
+struct _ScreenCastMonitor {
+  ScreenCastCallback callback;
+  gpointer user_data;
+  gchar* bus_address;
+
+  GCancellable* cancellable;
+  GDBusConnection* monitor;  // Becomes an eavesdrop-only monitor.
+  GDBusConnection* bus;      // Ordinary connection for PID lookups.
+  guint filter_id;
+
+  GQueue pending;        // PendingStart*, oldest first.
+  GHashTable* sessions;  // session path → ActiveSession*
+};
+
+// Handed from the GDBus worker thread to the main loop. The filter's own
+// context has no |message|.
+typedef struct {
+  ScreenCastMonitor* self;
+  GCancellable* cancellable;
+  GDBusMessage* message;
+} MonitoredMessage;
+
+typedef struct {
+  ScreenCastMonitor* self;
+  gchar* session;
+} AppNameLookup;
+
+static gboolean is_cancelled(const GError* error) {
+  return g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+}
+
+static void pending_start_free(gpointer data) {
+  PendingStart* start = (PendingStart*)data;
+  g_free(start->sender);
+  g_free(start->session);
+  g_free(start->request);
+  g_free(start);
+}
+
+static void active_session_free(gpointer data) {
+  ActiveSession* session = (ActiveSession*)data;
+  g_free(session->sender);
+  g_free(session->app_name);
+  g_free(session);
+}
+
+// The portal derives request handles from the caller's unique name
+// (":1.42" → "1_42") and the handle_token option.
+static gchar* build_request_path(const gchar* sender, const gchar* token) {
+  g_autofree gchar* escaped = g_strdup(sender[0] == ':' ? sender + 1 : sender);
+  g_strdelimit(escaped, ".", '_');
+  return g_strconcat(REQUEST_PATH_PREFIX, escaped, "/", token, NULL);
+}
+
+static void end_session(ScreenCastMonitor* self, const gchar* session) {
+  if (session == NULL) return;
+  if (!g_hash_table_remove(self->sessions, session)) return;
+  if (self->callback != NULL) {
+    self->callback(session, NULL, FALSE, self->user_data);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Application names
+// ---------------------------------------------------------------------------
+
+static void on_process_id(GObject* source,
+                          GAsyncResult* result,
+                          gpointer user_data) {
+  AppNameLookup* lookup = (AppNameLookup*)user_data;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GVariant) reply = g_dbus_connection_call_finish(
+      G_DBUS_CONNECTION(source), result, &error);
+  if (reply == NULL && is_cancelled(error)) {
+    g_free(lookup->session);
+    g_free(lookup);
+    return;
+  }
+
+  ScreenCastMonitor* self = lookup->self;
+  ActiveSession* session =
+      (ActiveSession*)g_hash_table_lookup(self->sessions, lookup->session);
+  if (reply != NULL && session != NULL) {
+    guint32 pid = 0;
+    g_variant_get(reply, "(u)", &pid);
+    g_autofree gchar* comm_path = g_strdup_printf("/proc/%u/comm", pid);
+    gchar* comm = NULL;
+    if (g_file_get_contents(comm_path, &comm, NULL, NULL)) {
+      g_free(session->app_name);
+      session->app_name = g_strstrip(comm);
+      if (self->callback != NULL) {
+        self->callback(lookup->session, session->app_name, TRUE,
+                       self->user_data);
+      }
+    }
+  }
+  g_free(lookup->session);
+  g_free(lookup);
+}
+
+static void look_up_app_name(ScreenCastMonitor* self,
+                             const gchar* session,
+                             const gchar* sender) {
+  if (self->bus == NULL) return;
+
+  AppNameLookup* lookup = g_new0(AppNameLookup, 1);
+  lookup->self = self;
+  lookup->session = g_strdup(session);
+  g_dbus_connection_call(self->bus, DBUS_NAME, DBUS_PATH, DBUS_NAME,
+                         "GetConnectionUnixProcessID",
+                         g_variant_new("(s)", sender), G_VARIANT_TYPE("(u)"),
+                         G_DBUS_CALL_FLAGS_NONE, -1, self->cancellable,
+                         on_process_id, lookup);
+}
+
+// ---------------------------------------------------------------------------
+// Monitored messages
+// ---------------------------------------------------------------------------
+
+static void on_start_call(ScreenCastMonitor* self,
+                          const gchar* sender,
+                          GVariant* body) {
+  if (sender == NULL || body == NULL ||
+      !g_variant_is_of_type(body, G_VARIANT_TYPE("(osa{sv})"))) {
+    return;
+  }
+
+  const gchar* session = NULL;
+  g_autoptr(GVariant) options = NULL;
+  g_variant_get(body, "(&o&s@a{sv})", &session, NULL, &options);
+
+  PendingStart* start = g_new0(PendingStart, 1);
+  start->sender = g_strdup(sender);
+  start->session = g_strdup(session);
+  const gchar* token = NULL;
+  if (g_variant_lookup(options, "handle_token", "&s", &token)) {
+    start->request = build_request_path(sender, token);
+  }
+  g_queue_push_tail(&self->pending, start);
+
+  while (g_queue_get_length(&self->pending) > MAX_PENDING_STARTS) {
+    pending_start_free(g_queue_pop_head(&self->pending));
+  }
+}
+
+// Finds the Start call a Response answers: by request handle when the
+// caller chose the token, otherwise the caller's oldest pending Start.
+static GList* find_pending_start(ScreenCastMonitor* self,
+                                 const gchar* request,
+                                 const gchar* destination) {
+  GList* fallback = NULL;
+  for (GList* l = self->pending.head; l != NULL; l = l->next) {
+    PendingStart* start = (PendingStart*)l->data;
+    if (start->request != NULL) {
+      if (g_strcmp0(start->request, request) == 0) return l;
+    } else if (fallback == NULL &&
+               g_strcmp0(start->sender, destination) == 0) {
+      fallback = l;
+    }
+  }
+  return fallback;
+}
+
+static void on_response(ScreenCastMonitor* self,
+                        const gchar* request,
+                        const gchar* destination,
+                        GVariant* body) {
+  GList* link = find_pending_start(self, request, destination);
+  if (link == NULL) return;  // Not a ScreenCast.Start request.
+
+  PendingStart* start = (PendingStart*)link->data;
+  g_queue_delete_link(&self->pending, link);
+
+  guint32 response = 2;
+  g_autoptr(GVariant) results = NULL;
+  if (body != NULL && g_variant_is_of_type(body, G_VARIANT_TYPE("(ua{sv})"))) {
+    g_variant_get(body, "(u@a{sv})", &response, &results);
+  }
+  g_autoptr(GVariant) streams =
+      results != NULL ? g_variant_lookup_value(results, "streams", NULL)
+                      : NULL;
+
+  // 0 = the user allowed the screencast and streams were set up.
+  if (response == 0 && streams != NULL &&
+      !g_hash_table_contains(self->sessions, start->session)) {
+    ActiveSession* session = g_new0(ActiveSession, 1);
+    session->sender = g_strdup(start->sender);
+    g_hash_table_insert(self->sessions, g_strdup(start->session), session);
+    if (self->callback != NULL) {
+      self->callback(start->session, "", TRUE, self->user_data);
+    }
+    look_up_app_name(self, start->session, start->sender);
+  }
+  pending_start_free(start);
+}
+
+// A client left the bus without closing its sessions.
+static void on_name_lost(ScreenCastMonitor* self, GVariant* body) {
+  if (body == NULL || !g_variant_is_of_type(body, G_VARIANT_TYPE("(sss)"))) {
+    return;
+  }
+  const gchar* name = NULL;
+  g_variant_get(body, "(&s&s&s)", &name, NULL, NULL);
+  if (name[0] != ':') return;
+
+  for (GList* l = self->pending.head; l != NULL;) {
+    GList* next = l->next;
+    if (g_strcmp0(((PendingStart*)l->data)->sender, name) == 0) {
+      pending_start_free(l->data);
+      g_queue_delete_link(&self->pending, l);
+    }
+    l = next;
+  }
+
+  GPtrArray* ended = g_ptr_array_new_with_free_func(g_free);
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->sessions);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    if (g_strcmp0(((ActiveSession*)value)->sender, name) == 0) {
+      g_ptr_array_add(ended, g_strdup((const gchar*)key));
+    }
+  }
+  for (guint i = 0; i < ended->len; i++) {
+    end_session(self, (const gchar*)g_ptr_array_index(ended, i));
+  }
+  g_ptr_array_unref(ended);
+}
+
+static void handle_message(ScreenCastMonitor* self, GDBusMessage* message) {
+  GDBusMessageType type = g_dbus_message_get_message_type(message);
+  const gchar* interface = g_dbus_message_get_interface(message);
+  const gchar* member = g_dbus_message_get_member(message);
+  GVariant* body = g_dbus_message_get_body(message);
+
+  if (type == G_DBUS_MESSAGE_TYPE_METHOD_CALL &&
+      g_strcmp0(interface, SCREENCAST_INTERFACE) == 0 &&
+      g_strcmp0(member, "Start") == 0) {
+    on_start_call(self, g_dbus_message_get_sender(message), body);
+  } else if (type == G_DBUS_MESSAGE_TYPE_SIGNAL &&
+             g_strcmp0(interface, REQUEST_INTERFACE) == 0 &&
+             g_strcmp0(member, "Response") == 0) {
+    on_response(self, g_dbus_message_get_path(message),
+                g_dbus_message_get_destination(message), body);
+  } else if (g_strcmp0(interface, SESSION_INTERFACE) == 0 &&
+             ((type == G_DBUS_MESSAGE_TYPE_SIGNAL &&
+               g_strcmp0(member, "Closed") == 0) ||
+              (type == G_DBUS_MESSAGE_TYPE_METHOD_CALL &&
+               g_strcmp0(member, "Close") == 0))) {
+    end_session(self, g_dbus_message_get_path(message));
+  } else if (type == G_DBUS_MESSAGE_TYPE_SIGNAL &&
+             g_strcmp0(member, "NameOwnerChanged") == 0) {
+    on_name_lost(self, body);
+  }
+}
+
+static void monitored_message_free(gpointer data) {
+  MonitoredMessage* monitored = (MonitoredMessage*)data;
+  g_clear_object(&monitored->message);
+  g_object_unref(monitored->cancellable);
+  g_free(monitored);
+}
+
+static gboolean dispatch_monitored_message(gpointer data) {
+  MonitoredMessage* monitored = (MonitoredMessage*)data;
+  if (!g_cancellable_is_cancelled(monitored->cancellable)) {
+    handle_message(monitored->self, monitored->message);
+  }
+  monitored_message_free(monitored);
+  return G_SOURCE_REMOVE;
+}
+
+// Runs on the GDBus worker thread. Monitored messages are addressed to
+// other connections and must not reach GDBus's own dispatch, which would
+// try to answer them — a monitor that sends anything is disconnected.
+static GDBusMessage* on_message(GDBusConnection* connection,
+                                GDBusMessage* message,
+                                gboolean incoming,
+                                gpointer user_data) {
+  if (!incoming) return message;
+
+  const gchar* destination = g_dbus_message_get_destination(message);
+  if (destination != NULL &&
+      g_strcmp0(destination, g_dbus_connection_get_unique_name(connection)) ==
+          0) {
+    return message;  // Our own traffic (e.g. the BecomeMonitor reply).
+  }
+
+  // |self| itself may be stopping on the main thread; only the filter's
+  // own reference to the cancellable is safe to use here.
+  MonitoredMessage* context = (MonitoredMessage*)user_data;
+  MonitoredMessage* monitored = g_new0(MonitoredMessage, 1);
+  monitored->self = context->self;
+  monitored->cancellable =
+      G_CANCELLABLE(g_object_ref(context->cancellable));
+  monitored->message = message;  // Takes the filter's reference.
+  g_idle_add(dispatch_monitored_message, monitored);
+  return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Connection setup
+// ---------------------------------------------------------------------------
+
+static void on_become_monitor(GObject* source,
+                              GAsyncResult* result,
+                              gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GVariant) reply = g_dbus_connection_call_finish(
+      G_DBUS_CONNECTION(source), result, &error);
+  if (reply == NULL) {
+    if (!is_cancelled(error)) {
+      g_warning("no_screenshot: cannot monitor screencast portal: %s",
+                error->message);
+    }
+    return;
+  }
+  g_message("no_screenshot: monitoring screencast portal sessions");
+}
+
+static void on_monitor_connected(GObject* source,
+                                 GAsyncResult* result,
+                                 gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  GDBusConnection* connection =
+      g_dbus_connection_new_for_address_finish(result, &error);
+  if (connection == NULL) {
+    if (!is_cancelled(error)) {
+      g_warning("no_screenshot: no session bus: %s", error->message);
+    }
+    return;
+  }
+
+  ScreenCastMonitor* self = (ScreenCastMonitor*)user_data;
+  self->monitor = connection;
+  MonitoredMessage* context = g_new0(MonitoredMessage, 1);
+  context->self = self;
+  context->cancellable = G_CANCELLABLE(g_object_ref(self->cancellable));
+  self->filter_id = g_dbus_connection_add_filter(
+      connection, on_message, context, monitored_message_free);
+  g_dbus_connection_call(
+      connection, DBUS_NAME, DBUS_PATH, "org.freedesktop.DBus.Monitoring",
+      "BecomeMonitor", g_variant_new("(^asu)", kMonitorRules, 0), NULL,
+      G_DBUS_CALL_FLAGS_NONE, -1, self->cancellable, on_become_monitor, self);
+}
+
+static void on_bus_connected(GObject* source,
+                             GAsyncResult* result,
+                             gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  GDBusConnection* connection =
+      g_dbus_connection_new_for_address_finish(result, &error);
+  if (connection == NULL) return;  // Apps are then reported unnamed.
+  ((ScreenCastMonitor*)user_data)->bus = connection;
+}
+
+ScreenCastMonitor* screencast_monitor_new(const gchar* bus_address,
+                                          ScreenCastCallback cb,
+                                          gpointer user_data) {
+  ScreenCastMonitor* self = g_new0(ScreenCastMonitor, 1);
+  self->callback = cb;
+  self->user_data = user_data;
+  self->bus_address = g_strdup(bus_address);
+  g_queue_init(&self->pending);
+  self->sessions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                         active_session_free);
+  return self;
+}
+
+void screencast_monitor_free(ScreenCastMonitor* self) {
+  if (self == NULL) return;
+  screencast_monitor_stop(self);
+  g_hash_table_unref(self->sessions);
+  g_free(self->bus_address);
+  g_free(self);
+}
+
+void screencast_monitor_start(ScreenCastMonitor* self) {
+  if (self->cancellable != NULL) return;  // Already started.
+
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar* address =
+      self->bus_address != NULL
+          ? g_strdup(self->bus_address)
+          : g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SESSION, NULL, &error);
+  if (address == NULL) {
+    g_warning("no_screenshot: no session bus: %s", error->message);
+    return;
+  }
+
+  // Two private connections: once a connection becomes a monitor it can no
+  // longer send, and the shared session connection must not be affected.
+  self->cancellable = g_cancellable_new();
+  GDBusConnectionFlags flags = (GDBusConnectionFlags)(
+      G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+      G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION);
+  g_dbus_connection_new_for_address(address, flags, NULL, self->cancellable,
+                                    on_monitor_connected, self);
+  g_dbus_connection_new_for_address(address, flags, NULL, self->cancellable,
+                                    on_bus_connected, self);
+}
+
+void screencast_monitor_stop(ScreenCastMonitor* self) {
+  if (self->cancellable != NULL) {
+    g_cancellable_cancel(self->cancellable);
+    g_clear_object(&self->cancellable);
+  }
+  if (self->monitor != NULL) {
+    g_dbus_connection_remove_filter(self->monitor, self->filter_id);
+    self->filter_id = 0;
+    g_dbus_connection_close(self->monitor, NULL, NULL, NULL);
+    g_clear_object(&self->monitor);
+  }
+  if (self->bus != NULL) {
+    g_dbus_connection_close(self->bus, NULL, NULL, NULL);
+    g_clear_object(&self->bus);
+  }
+  g_queue_clear_full(&self->pending, pending_start_free);
+  g_hash_table_remove_all(self->sessions);
+}
+
+guint screencast_monitor_get_count(ScreenCastMonitor* self) {
+  return g_hash_table_size(self->sessions);
+}
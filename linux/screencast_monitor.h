@@ -0,0 +1,36 @@
+#ifndef SCREENCAST_MONITOR_H_
+#define SCREENCAST_MONITOR_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Tracks screencasts started through the org.freedesktop.portal.ScreenCast
+// portal — browser screen sharing and Wayland recorders — by monitoring the
+// session bus. Purely event-driven.
+typedef struct _ScreenCastMonitor ScreenCastMonitor;
+
+// Invoked when a screencast session starts (|is_active| TRUE, possibly
+// again once |app_name| is known) or ends. |session| is the portal session
+// object path.
+typedef void (*ScreenCastCallback)(const gchar* session,
+                                   const gchar* app_name,
+                                   gboolean is_active,
+                                   gpointer user_data);
+
+// |bus_address| selects a bus other than the session bus (NULL), e.g. a
+// private dbus-daemon in tests.
+ScreenCastMonitor* screencast_monitor_new(const gchar* bus_address,
+                                          ScreenCastCallback cb,
+                                          gpointer user_data);
+void screencast_monitor_free(ScreenCastMonitor* self);
+
+void screencast_monitor_start(ScreenCastMonitor* self);
+void screencast_monitor_stop(ScreenCastMonitor* self);
+
+// Number of active screencast sessions.
+guint screencast_monitor_get_count(ScreenCastMonitor* self);
+
+G_END_DECLS
+
+#endif  // SCREENCAST_MONITOR_H_
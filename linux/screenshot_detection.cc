@@ -2,19 +2,88 @@
 
 #include <gio/gio.h>
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dir_scan.h"
+#include "recent_files_detection.h"
+#include "tracker_detection.h"
 
 #define MAX_MONITORS 4
-#define DEBOUNCE_SECONDS 2
+#define DEFAULT_BURST_GAP_MS 2000
+#define MAX_BURST_PATHS 8
+#define RECENT_PATHS 16
+
+// Overload protection: above STORM_EVENTS_PER_SECOND monitor events (e.g.
+// thousands of photos copied into ~/Pictures) the per-event monitors are
+// dropped and the directories are diffed every STORM_DIFF_INTERVAL_MS
+// instead. Monitoring resumes after STORM_QUIET_TICKS consecutive diffs
+// that saw fewer than STORM_QUIET_ENTRIES new entries.
+#define STORM_EVENTS_PER_SECOND 200
+#define STORM_DIFF_INTERVAL_MS 1000
+#define STORM_QUIET_ENTRIES 10
+#define STORM_QUIET_TICKS 3
+
+// The startup catch-up scan runs on a worker thread and gives up after
+// CATCH_UP_BUDGET_MS; the deadline is checked every CATCH_UP_CHECK_INTERVAL
+// directory entries.
+#define CATCH_UP_BUDGET_MS 500
+#define CATCH_UP_CHECK_INTERVAL 256
+
+typedef struct {
+  gchar* path;
+  GFileMonitor* monitor;
+
+  // Directory diffing state (overload mode only).
+  int dir_fd;
+  gint64 dir_mtime_ns;
+  guint entry_count;
+} WatchedDir;
 
 struct _ScreenshotDetection {
   ScreenshotDetectedCallback callback;
   gpointer user_data;
 
-  GFileMonitor* monitors[MAX_MONITORS];
-  int monitor_count;
+  WatchedDir dirs[MAX_MONITORS];
+  int dir_count;
+  gboolean is_started;
+
+  // Event rate measurement (monotonic microseconds).
+  gint64 rate_window_start;
+  guint rate_window_events;
+
+  // Overload mode — monitors dropped, directories diffed periodically.
+  gboolean is_overloaded;
+  guint storm_switch_id;  // Idle source deferring the switch.
+  guint diff_timer_id;
+  gint64 diff_cursor_ns;  // Files modified after this are new.
+  guint quiet_ticks;
+
+  // Catch-up of screenshots taken while not listening.
+  gint64 cursor_ms;
+  GCancellable* catch_up_cancellable;
+
+  // recently-used.xbel watcher — covers arbitrary save locations.
+  RecentFilesDetection* recent_files;
+
+  // Desktop search indexer subscription (when built with tracker-sparql).
+  TrackerDetection* tracker;
+
+  // Ring of recently reported paths; the same capture is usually seen both
+  // by a directory monitor and through recently-used.xbel.
+  gchar* recent_paths[RECENT_PATHS];
+  int recent_paths_next;
 
-  gint64 last_detection_time;  // monotonic microseconds
+  // Burst sessionization — a burst is open while burst_timer_id != 0.
+  guint burst_gap_ms;
+  guint burst_timer_id;
+  gchar* burst_source_app;
+  gchar* burst_last_path;
+  gchar* burst_paths[MAX_BURST_PATHS + 1];  // NULL-terminated
+  ScreenshotBurst burst;
 };
 
 static gboolean is_screenshot_filename(const gchar* basename) {
@@ -68,26 +137,280 @@ static const gchar* infer_source_app(const gchar* basename) {
   return "";
 }
 
+static void burst_reset(ScreenshotDetection* self) {
+  if (self->burst_timer_id != 0) {
+    g_source_remove(self->burst_timer_id);
+    self->burst_timer_id = 0;
+  }
+  for (int i = 0; i < self->burst.n_paths; i++) {
+    g_free(self->burst_paths[i]);
+    self->burst_paths[i] = NULL;
+  }
+  g_clear_pointer(&self->burst_source_app, g_free);
+  g_clear_pointer(&self->burst_last_path, g_free);
+  memset(&self->burst, 0, sizeof(self->burst));
+  self->burst.paths = (const gchar* const*)self->burst_paths;
+}
+
+// Emits the closing event of the current burst (only when it grouped more
+// than one capture — a single capture was fully reported when it opened).
+static void burst_close(ScreenshotDetection* self) {
+  if (self->burst.count > 1 && self->callback != NULL) {
+    self->burst.is_closed = TRUE;
+    self->callback(self->burst_last_path, self->burst.last_timestamp_ms,
+                   self->burst_source_app, &self->burst, self->user_data);
+  }
+  burst_reset(self);
+}
+
+static gboolean on_burst_gap_elapsed(gpointer user_data) {
+  ScreenshotDetection* self = (ScreenshotDetection*)user_data;
+  self->burst_timer_id = 0;
+  burst_close(self);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean remember_path(ScreenshotDetection* self, const gchar* path) {
+  for (int i = 0; i < RECENT_PATHS; i++) {
+    if (g_strcmp0(self->recent_paths[i], path) == 0) return FALSE;
+  }
+  g_free(self->recent_paths[self->recent_paths_next]);
+  self->recent_paths[self->recent_paths_next] = g_strdup(path);
+  self->recent_paths_next = (self->recent_paths_next + 1) % RECENT_PATHS;
+  return TRUE;
+}
+
+static void report_screenshot(ScreenshotDetection* self,
+                              const gchar* path,
+                              gint64 timestamp_ms,
+                              const gchar* source_app) {
+  if (!remember_path(self, path)) return;  // Already reported.
+  self->cursor_ms = MAX(self->cursor_ms, timestamp_ms);
+
+  gboolean is_open = self->burst_timer_id != 0;
+
+  if (is_open && g_strcmp0(source_app, self->burst_source_app) == 0) {
+    // Same tool within the gap — extend the burst silently.
+    g_source_remove(self->burst_timer_id);
+    self->burst.count++;
+    self->burst.last_timestamp_ms = timestamp_ms;
+    if (self->burst.n_paths < MAX_BURST_PATHS) {
+      self->burst_paths[self->burst.n_paths++] = g_strdup(path);
+    }
+    g_free(self->burst_last_path);
+    self->burst_last_path = g_strdup(path);
+  } else {
+    if (is_open) burst_close(self);
+
+    self->burst_source_app = g_strdup(source_app);
+    self->burst_last_path = g_strdup(path);
+    self->burst_paths[0] = g_strdup(path);
+    self->burst.n_paths = 1;
+    self->burst.count = 1;
+    self->burst.first_timestamp_ms = timestamp_ms;
+    self->burst.last_timestamp_ms = timestamp_ms;
+    self->burst.is_closed = FALSE;
+
+    if (self->callback != NULL) {
+      self->callback(path, timestamp_ms, source_app, &self->burst,
+                     self->user_data);
+    }
+  }
+
+  self->burst_timer_id =
+      g_timeout_add(self->burst_gap_ms, on_burst_gap_elapsed, self);
+}
+
+// Maps image metadata written by screenshot tools (PNG "Software", EXIF
+// software tags) to a source app name, or NULL if not a known tool.
+static const gchar* infer_source_app_from_generator(const gchar* generator) {
+  static const struct {
+    const gchar* needle;
+    const gchar* source_app;
+  } kGenerators[] = {
+      {"gnome-screenshot", "GNOME Screenshot"},
+      {"spectacle", "KDE Spectacle"},
+      {"flameshot", "Flameshot"},
+      {"shutter", "Shutter"},
+      {"scrot", "scrot"},
+      {"maim", "maim"},
+      {"ksnip", "ksnip"},
+  };
+
+  if (generator == NULL || generator[0] == '\0') return NULL;
+  g_autofree gchar* lower = g_ascii_strdown(generator, -1);
+  for (gsize i = 0; i < G_N_ELEMENTS(kGenerators); i++) {
+    if (strstr(lower, kGenerators[i].needle) != NULL) {
+      return kGenerators[i].source_app;
+    }
+  }
+  return NULL;
+}
+
+static void start_dir_monitor(ScreenshotDetection* self, WatchedDir* dir);
+static void stop_dir_monitor(WatchedDir* dir);
+
+static gint64 stat_mtime_ns(const struct stat* st) {
+  return (gint64)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+typedef struct {
+  ScreenshotDetection* self;
+  WatchedDir* dir;
+  guint entry_count;
+  gint64 newest_ns;
+} DiffContext;
+
+static gboolean diff_entry(const gchar* name,
+                           guchar d_type,
+                           guint64 inode,
+                           gpointer data) {
+  DiffContext* ctx = (DiffContext*)data;
+  ctx->entry_count++;
+
+  if (d_type != DT_REG && d_type != DT_UNKNOWN) return TRUE;
+  if (!is_screenshot_filename(name)) return TRUE;
+
+  // Only screenshot-named entries are stat'ed.
+  struct stat st;
+  if (fstatat(ctx->dir->dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0 ||
+      !S_ISREG(st.st_mode)) {
+    return TRUE;
+  }
+  gint64 mtime_ns = stat_mtime_ns(&st);
+  if (mtime_ns <= ctx->self->diff_cursor_ns) return TRUE;
+
+  if (mtime_ns > ctx->newest_ns) ctx->newest_ns = mtime_ns;
+  g_autofree gchar* path = g_build_filename(ctx->dir->path, name, NULL);
+  report_screenshot(ctx->self, path, mtime_ns / 1000000,
+                    infer_source_app(name));
+  return TRUE;
+}
+
+// Diffs every watched directory against the cursor and returns the number
+// of entries added since the previous diff. Directories whose mtime did not
+// move are skipped with a single fstat.
+static guint diff_directories(ScreenshotDetection* self) {
+  guint added = 0;
+  gint64 newest_ns = self->diff_cursor_ns;
+
+  for (int i = 0; i < self->dir_count; i++) {
+    WatchedDir* dir = &self->dirs[i];
+    if (dir->dir_fd < 0) continue;
+
+    struct stat st;
+    if (fstat(dir->dir_fd, &st) != 0) continue;
+    if (stat_mtime_ns(&st) == dir->dir_mtime_ns) continue;
+    dir->dir_mtime_ns = stat_mtime_ns(&st);
+
+    DiffContext ctx = {self, dir, 0, newest_ns};
+    if (!dir_scan(dir->dir_fd, diff_entry, &ctx)) continue;
+    if (ctx.entry_count > dir->entry_count) {
+      added += ctx.entry_count - dir->entry_count;
+    }
+    dir->entry_count = ctx.entry_count;
+    newest_ns = ctx.newest_ns;
+  }
+
+  self->diff_cursor_ns = newest_ns;
+  return added;
+}
+
+static void leave_overload_mode(ScreenshotDetection* self) {
+  if (self->diff_timer_id != 0) {
+    g_source_remove(self->diff_timer_id);
+    self->diff_timer_id = 0;
+  }
+
+  // Re-arm the monitors first, then diff once more so nothing created in
+  // between is missed.
+  for (int i = 0; i < self->dir_count; i++) {
+    start_dir_monitor(self, &self->dirs[i]);
+  }
+  self->is_overloaded = FALSE;
+  diff_directories(self);
+
+  for (int i = 0; i < self->dir_count; i++) {
+    if (self->dirs[i].dir_fd >= 0) {
+      close(self->dirs[i].dir_fd);
+      self->dirs[i].dir_fd = -1;
+    }
+  }
+  self->rate_window_start = g_get_monotonic_time();
+  self->rate_window_events = 0;
+  g_message("no_screenshot: file activity settled, monitoring resumed");
+}
+
+static gboolean on_diff_tick(gpointer user_data) {
+  ScreenshotDetection* self = (ScreenshotDetection*)user_data;
+
+  guint added = diff_directories(self);
+  self->quiet_ticks = added < STORM_QUIET_ENTRIES ? self->quiet_ticks + 1 : 0;
+  if (self->quiet_ticks < STORM_QUIET_TICKS) return G_SOURCE_CONTINUE;
+
+  self->diff_timer_id = 0;
+  leave_overload_mode(self);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean enter_overload_mode(gpointer user_data) {
+  ScreenshotDetection* self = (ScreenshotDetection*)user_data;
+  self->storm_switch_id = 0;
+
+  // Drop the monitors — their queued events are discarded with them.
+  for (int i = 0; i < self->dir_count; i++) {
+    WatchedDir* dir = &self->dirs[i];
+    stop_dir_monitor(dir);
+    dir->dir_fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    dir->dir_mtime_ns = 0;
+    dir->entry_count = 0;
+  }
+
+  // Anything modified since the storm started may have been dropped.
+  self->diff_cursor_ns =
+      (g_get_real_time() - G_USEC_PER_SEC) * (gint64)1000;
+  self->quiet_ticks = 0;
+  diff_directories(self);
+  self->diff_timer_id =
+      g_timeout_add(STORM_DIFF_INTERVAL_MS, on_diff_tick, self);
+  g_message("no_screenshot: file activity storm, switching to directory "
+            "diffing");
+  return G_SOURCE_REMOVE;
+}
+
+// Measures the monitor event rate. Returns FALSE once the rate crossed the
+// overload threshold and events should be ignored.
+static gboolean note_monitor_event(ScreenshotDetection* self) {
+  if (self->is_overloaded) return FALSE;
+
+  gint64 now = g_get_monotonic_time();
+  if (now - self->rate_window_start >= G_USEC_PER_SEC) {
+    self->rate_window_start = now;
+    self->rate_window_events = 0;
+  }
+  if (++self->rate_window_events <= STORM_EVENTS_PER_SECOND) return TRUE;
+
+  // Monitors cannot be dropped from inside their own signal emission.
+  self->is_overloaded = TRUE;
+  self->storm_switch_id = g_idle_add(enter_overload_mode, self);
+  return FALSE;
+}
+
 static void on_file_changed(GFileMonitor* monitor,
                             GFile* file,
                             GFile* other_file,
                             GFileMonitorEvent event_type,
                             gpointer user_data) {
-  if (event_type != G_FILE_MONITOR_EVENT_CREATED) return;
-
   ScreenshotDetection* self = (ScreenshotDetection*)user_data;
+  if (!note_monitor_event(self)) return;
+
+  if (event_type != G_FILE_MONITOR_EVENT_CREATED) return;
 
   g_autofree gchar* basename = g_file_get_basename(file);
   if (basename == NULL || !is_screenshot_filename(basename)) return;
 
-  // Debounce: ignore events within DEBOUNCE_SECONDS of the last detection.
-  gint64 now = g_get_monotonic_time();
-  if ((now - self->last_detection_time) < (DEBOUNCE_SECONDS * G_USEC_PER_SEC))
-    return;
-  self->last_detection_time = now;
-
   g_autofree gchar* path = g_file_get_path(file);
-  if (path != NULL && self->callback != NULL) {
+  if (path != NULL) {
     // Get file modification time as best approximation of creation time.
     gint64 timestamp_ms = 0;
     g_autoptr(GError) error = NULL;
@@ -104,50 +427,238 @@ static void on_file_changed(GFileMonitor* monitor,
       timestamp_ms = g_get_real_time() / 1000;
     }
 
-    const gchar* source_app = infer_source_app(basename);
-    self->callback(path, timestamp_ms, source_app, self->user_data);
+    report_screenshot(self, path, timestamp_ms, infer_source_app(basename));
   }
 }
 
-static void add_monitor(ScreenshotDetection* self, const gchar* dir_path) {
-  if (dir_path == NULL || self->monitor_count >= MAX_MONITORS) return;
+static void on_recent_screenshot(const gchar* file_path,
+                                 gint64 timestamp_ms,
+                                 const gchar* source_app,
+                                 gpointer user_data) {
+  report_screenshot((ScreenshotDetection*)user_data, file_path, timestamp_ms,
+                    source_app);
+}
 
-  // Only monitor directories that exist.
-  if (!g_file_test(dir_path, G_FILE_TEST_IS_DIR)) return;
+static void on_indexed_image(const gchar* file_path,
+                             gint64 timestamp_ms,
+                             const gchar* generator,
+                             gpointer user_data) {
+  ScreenshotDetection* self = (ScreenshotDetection*)user_data;
+
+  const gchar* source_app = infer_source_app_from_generator(generator);
+  if (source_app == NULL) {
+    g_autofree gchar* basename = g_path_get_basename(file_path);
+    if (!is_screenshot_filename(basename)) return;
+    source_app = infer_source_app(basename);
+  }
+  report_screenshot(self, file_path, timestamp_ms, source_app);
+}
 
-  g_autoptr(GFile) dir = g_file_new_for_path(dir_path);
+static void start_dir_monitor(ScreenshotDetection* self, WatchedDir* dir) {
+  g_autoptr(GFile) file = g_file_new_for_path(dir->path);
   g_autoptr(GError) error = NULL;
 
-  GFileMonitor* monitor =
-      g_file_monitor_directory(dir, G_FILE_MONITOR_NONE, NULL, &error);
-  if (monitor == NULL) {
-    g_warning("no_screenshot: failed to monitor %s: %s", dir_path,
+  dir->monitor =
+      g_file_monitor_directory(file, G_FILE_MONITOR_NONE, NULL, &error);
+  if (dir->monitor == NULL) {
+    g_warning("no_screenshot: failed to monitor %s: %s", dir->path,
               error->message);
     return;
   }
+  g_signal_connect(dir->monitor, "changed", G_CALLBACK(on_file_changed),
+                   self);
+}
 
-  g_signal_connect(monitor, "changed", G_CALLBACK(on_file_changed), self);
-  self->monitors[self->monitor_count++] = monitor;
+static void stop_dir_monitor(WatchedDir* dir) {
+  if (dir->monitor == NULL) return;
+  g_file_monitor_cancel(dir->monitor);
+  g_clear_object(&dir->monitor);
+}
+
+static void add_monitor(ScreenshotDetection* self, const gchar* dir_path) {
+  if (dir_path == NULL || self->dir_count >= MAX_MONITORS) return;
+
+  // Only monitor directories that exist.
+  if (!g_file_test(dir_path, G_FILE_TEST_IS_DIR)) return;
+
+  WatchedDir* dir = &self->dirs[self->dir_count];
+  dir->path = g_strdup(dir_path);
+  dir->dir_fd = -1;
+  start_dir_monitor(self, dir);
+  if (dir->monitor == NULL) {
+    g_clear_pointer(&dir->path, g_free);
+    return;
+  }
+  self->dir_count++;
   g_message("no_screenshot: monitoring %s", dir_path);
 }
 
+// ---------------------------------------------------------------------------
+// Startup catch-up scan
+// ---------------------------------------------------------------------------
+
+typedef struct {
+  gchar* paths[MAX_MONITORS];
+  int n_paths;
+  gint64 since_ns;     // Exclusive lower bound on mtime.
+  gint64 deadline_us;  // Monotonic.
+} CatchUpRequest;
+
+typedef struct {
+  gchar* path;
+  gint64 timestamp_ms;
+  const gchar* source_app;
+} CatchUpResult;
+
+typedef struct {
+  const CatchUpRequest* request;
+  GCancellable* cancellable;
+  GPtrArray* results;
+  const gchar* dir_path;
+  int dir_fd;
+  guint entries;
+  gboolean stopped;
+} CatchUpScan;
+
+static void catch_up_request_free(gpointer data) {
+  CatchUpRequest* request = (CatchUpRequest*)data;
+  for (int i = 0; i < request->n_paths; i++) g_free(request->paths[i]);
+  g_free(request);
+}
+
+static void catch_up_result_free(gpointer data) {
+  CatchUpResult* result = (CatchUpResult*)data;
+  g_free(result->path);
+  g_free(result);
+}
+
+static gint compare_catch_up_results(gconstpointer a, gconstpointer b) {
+  const CatchUpResult* ra = *(const CatchUpResult* const*)a;
+  const CatchUpResult* rb = *(const CatchUpResult* const*)b;
+  return (ra->timestamp_ms > rb->timestamp_ms) -
+         (ra->timestamp_ms < rb->timestamp_ms);
+}
+
+// Runs on the worker thread.
+static gboolean catch_up_entry(const gchar* name,
+                               guchar d_type,
+                               guint64 inode,
+                               gpointer data) {
+  CatchUpScan* scan = (CatchUpScan*)data;
+
+  if (++scan->entries % CATCH_UP_CHECK_INTERVAL == 0 &&
+      (g_get_monotonic_time() > scan->request->deadline_us ||
+       g_cancellable_is_cancelled(scan->cancellable))) {
+    scan->stopped = TRUE;
+    return FALSE;
+  }
+
+  if (d_type != DT_REG && d_type != DT_UNKNOWN) return TRUE;
+  if (!is_screenshot_filename(name)) return TRUE;
+
+  // Only screenshot-named entries cost a statx.
+  struct statx stx;
+  if (statx(scan->dir_fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+            STATX_TYPE | STATX_MTIME, &stx) != 0 ||
+      !S_ISREG(stx.stx_mode)) {
+    return TRUE;
+  }
+  gint64 mtime_ns =
+      (gint64)stx.stx_mtime.tv_sec * 1000000000 + stx.stx_mtime.tv_nsec;
+  if (mtime_ns <= scan->request->since_ns) return TRUE;
+
+  CatchUpResult* result = g_new0(CatchUpResult, 1);
+  result->path = g_build_filename(scan->dir_path, name, NULL);
+  result->timestamp_ms = mtime_ns / 1000000;
+  result->source_app = infer_source_app(name);
+  g_ptr_array_add(scan->results, result);
+  return TRUE;
+}
+
+static void catch_up_thread(GTask* task,
+                            gpointer source_object,
+                            gpointer task_data,
+                            GCancellable* cancellable) {
+  const CatchUpRequest* request = (const CatchUpRequest*)task_data;
+  CatchUpScan scan = {request, cancellable, NULL, NULL, -1, 0, FALSE};
+  scan.results = g_ptr_array_new_with_free_func(catch_up_result_free);
+
+  for (int i = 0; i < request->n_paths && !scan.stopped; i++) {
+    scan.dir_path = request->paths[i];
+    scan.dir_fd = open(scan.dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (scan.dir_fd < 0) continue;
+    dir_scan(scan.dir_fd, catch_up_entry, &scan);
+    close(scan.dir_fd);
+  }
+
+  if (scan.stopped && !g_cancellable_is_cancelled(cancellable)) {
+    g_message("no_screenshot: catch-up scan stopped after %d ms",
+              CATCH_UP_BUDGET_MS);
+  }
+  g_task_return_pointer(task, scan.results,
+                        (GDestroyNotify)g_ptr_array_unref);
+}
+
+static void on_catch_up_done(GObject* source,
+                             GAsyncResult* result,
+                             gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  GPtrArray* results =
+      (GPtrArray*)g_task_propagate_pointer(G_TASK(result), &error);
+  if (results == NULL) return;  // Cancelled — |user_data| may be gone.
+
+  ScreenshotDetection* self = (ScreenshotDetection*)user_data;
+  g_clear_object(&self->catch_up_cancellable);
+
+  // Oldest first, so captures taken back to back form bursts.
+  g_ptr_array_sort(results, compare_catch_up_results);
+  for (guint i = 0; i < results->len; i++) {
+    CatchUpResult* r = (CatchUpResult*)g_ptr_array_index(results, i);
+    report_screenshot(self, r->path, r->timestamp_ms, r->source_app);
+  }
+  g_ptr_array_unref(results);
+}
+
+static void start_catch_up(ScreenshotDetection* self) {
+  CatchUpRequest* request = g_new0(CatchUpRequest, 1);
+  for (int i = 0; i < self->dir_count; i++) {
+    request->paths[request->n_paths++] = g_strdup(self->dirs[i].path);
+  }
+  request->since_ns = self->cursor_ms * 1000000;
+  request->deadline_us =
+      g_get_monotonic_time() + CATCH_UP_BUDGET_MS * 1000;
+
+  self->catch_up_cancellable = g_cancellable_new();
+  GTask* task =
+      g_task_new(NULL, self->catch_up_cancellable, on_catch_up_done, self);
+  g_task_set_task_data(task, request, catch_up_request_free);
+  g_task_run_in_thread(task, catch_up_thread);
+  g_object_unref(task);
+}
+
 ScreenshotDetection* screenshot_detection_new(ScreenshotDetectedCallback cb,
                                               gpointer user_data) {
   ScreenshotDetection* self = g_new0(ScreenshotDetection, 1);
   self->callback = cb;
   self->user_data = user_data;
-  self->last_detection_time = 0;
+  self->burst_gap_ms = DEFAULT_BURST_GAP_MS;
+  self->recent_files = recent_files_detection_new(on_recent_screenshot, self);
+  self->tracker = tracker_detection_new(NULL, on_indexed_image, self);
+  burst_reset(self);
   return self;
 }
 
 void screenshot_detection_free(ScreenshotDetection* self) {
   if (self == NULL) return;
   screenshot_detection_stop(self);
+  recent_files_detection_free(self->recent_files);
+  tracker_detection_free(self->tracker);
   g_free(self);
 }
 
 void screenshot_detection_start(ScreenshotDetection* self) {
-  if (self->monitor_count > 0) return;  // Already started.
+  if (self->is_started) return;  // Already started.
+  self->is_started = TRUE;
 
   const gchar* home = g_get_home_dir();
 
@@ -166,13 +677,70 @@ void screenshot_detection_start(ScreenshotDetection* self) {
   if (xdg_pictures != NULL && g_strcmp0(xdg_pictures, pictures_dir) != 0) {
     add_monitor(self, xdg_pictures);
   }
+
+  // Screenshots taken while the app was not listening.
+  if (self->cursor_ms > 0 && self->dir_count > 0) {
+    start_catch_up(self);
+  }
+
+  // recently-used.xbel (tools saving anywhere else)
+  recent_files_detection_start(self->recent_files);
+
+  // Desktop search indexer (every indexed directory, no extra watches)
+  tracker_detection_start(self->tracker);
 }
 
 void screenshot_detection_stop(ScreenshotDetection* self) {
-  for (int i = 0; i < self->monitor_count; i++) {
-    g_file_monitor_cancel(self->monitors[i]);
-    g_object_unref(self->monitors[i]);
-    self->monitors[i] = NULL;
+  if (self->catch_up_cancellable != NULL) {
+    g_cancellable_cancel(self->catch_up_cancellable);
+    g_clear_object(&self->catch_up_cancellable);
+  }
+  if (self->is_started) {
+    self->cursor_ms = MAX(self->cursor_ms, g_get_real_time() / 1000);
+  }
+
+  if (self->storm_switch_id != 0) {
+    g_source_remove(self->storm_switch_id);
+    self->storm_switch_id = 0;
+  }
+  if (self->diff_timer_id != 0) {
+    g_source_remove(self->diff_timer_id);
+    self->diff_timer_id = 0;
+  }
+  self->is_overloaded = FALSE;
+  self->rate_window_events = 0;
+
+  for (int i = 0; i < self->dir_count; i++) {
+    WatchedDir* dir = &self->dirs[i];
+    stop_dir_monitor(dir);
+    if (dir->dir_fd >= 0) close(dir->dir_fd);
+    dir->dir_fd = -1;
+    g_clear_pointer(&dir->path, g_free);
+  }
+  self->dir_count = 0;
+  recent_files_detection_stop(self->recent_files);
+  tracker_detection_stop(self->tracker);
+  self->is_started = FALSE;
+
+  for (int i = 0; i < RECENT_PATHS; i++) {
+    g_clear_pointer(&self->recent_paths[i], g_free);
   }
-  self->monitor_count = 0;
+  self->recent_paths_next = 0;
+
+  // Drop any open burst — no closing event is reported after stopping.
+  burst_reset(self);
+}
+
+void screenshot_detection_set_cursor(ScreenshotDetection* self,
+                                     gint64 cursor_ms) {
+  self->cursor_ms = cursor_ms;
+}
+
+gint64 screenshot_detection_get_cursor(ScreenshotDetection* self) {
+  return self->cursor_ms;
+}
+
+void screenshot_detection_set_burst_gap(ScreenshotDetection* self,
+                                        guint gap_ms) {
+  self->burst_gap_ms = gap_ms > 0 ? gap_ms : DEFAULT_BURST_GAP_MS;
 }
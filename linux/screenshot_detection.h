@@ -7,10 +7,27 @@ G_BEGIN_DECLS
 
 typedef struct _ScreenshotDetection ScreenshotDetection;
 
-// Callback invoked when a new screenshot file is detected.
+// Consecutive captures from the same tool, grouped while the gap between
+// them stays below the configured burst gap.
+typedef struct {
+  gint count;
+  gint64 first_timestamp_ms;
+  gint64 last_timestamp_ms;
+  // The first |n_paths| captured paths (bounded, later paths are dropped).
+  const gchar* const* paths;
+  gint n_paths;
+  // TRUE for the final event emitted once the burst gap has elapsed.
+  gboolean is_closed;
+} ScreenshotBurst;
+
+// Callback invoked when a new screenshot file is detected. The first capture
+// of a burst is reported immediately; if more captures follow within the
+// burst gap, a single closing event summarising the burst is reported once
+// the gap elapses.
 typedef void (*ScreenshotDetectedCallback)(const gchar* file_path,
                                            gint64 timestamp_ms,
                                            const gchar* source_app,
+                                           const ScreenshotBurst* burst,
                                            gpointer user_data);
 
 ScreenshotDetection* screenshot_detection_new(ScreenshotDetectedCallback cb,
@@ -20,6 +37,21 @@ void screenshot_detection_free(ScreenshotDetection* self);
 void screenshot_detection_start(ScreenshotDetection* self);
 void screenshot_detection_stop(ScreenshotDetection* self);
 
+// Screenshots modified after |cursor_ms| (ms since epoch) in the watched
+// directories — i.e. taken while the app was not listening — are reported
+// by a background catch-up scan when listening starts. 0 disables it.
+void screenshot_detection_set_cursor(ScreenshotDetection* self,
+                                     gint64 cursor_ms);
+
+// Time up to which screenshots have been seen (ms since epoch). Advances
+// with every report and to the current time when listening stops.
+gint64 screenshot_detection_get_cursor(ScreenshotDetection* self);
+
+// Maximum gap between two captures of the same burst (default 2000 ms; 0
+// restores the default).
+void screenshot_detection_set_burst_gap(ScreenshotDetection* self,
+                                        guint gap_ms);
+
 G_END_DECLS
 
 #endif  // SCREENSHOT_DETECTION_H_
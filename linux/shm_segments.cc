@@ -0,0 +1,104 @@
+#include "shm_segments.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_SHM_PATH "/proc/sysvipc/shm"
+// Grown as needed and kept, so steady-state reads do not allocate.
+#define INITIAL_BUFFER_SIZE 8192
+
+struct _ShmSegments {
+  gchar* path;
+  GArray* sizes;  // guint64
+  gchar* buffer;
+  gsize buffer_size;
+};
+
+ShmSegments* shm_segments_new(const gchar* path) {
+  ShmSegments* self = g_new0(ShmSegments, 1);
+  self->path = g_strdup(path != NULL ? path : DEFAULT_SHM_PATH);
+  self->sizes = g_array_new(FALSE, FALSE, sizeof(guint64));
+  self->buffer_size = INITIAL_BUFFER_SIZE;
+  self->buffer = (gchar*)g_malloc(self->buffer_size);
+  return self;
+}
+
+void shm_segments_free(ShmSegments* self) {
+  if (self == NULL) return;
+  g_free(self->path);
+  g_array_unref(self->sizes);
+  g_free(self->buffer);
+  g_free(self);
+}
+
+void shm_segments_set_sizes(ShmSegments* self,
+                            const guint64* sizes,
+                            guint n_sizes) {
+  g_array_set_size(self->sizes, 0);
+  g_array_append_vals(self->sizes, sizes, n_sizes);
+}
+
+gboolean shm_segments_has_sizes(ShmSegments* self) {
+  return self->sizes->len > 0;
+}
+
+static gboolean is_watched_size(ShmSegments* self, guint64 size) {
+  for (guint i = 0; i < self->sizes->len; i++) {
+    if (g_array_index(self->sizes, guint64, i) == size) return TRUE;
+  }
+  return FALSE;
+}
+
+// Reads the whole file into |buffer|, NUL-terminated. Returns its length,
+// or -1.
+static gssize read_table(ShmSegments* self) {
+  int fd = open(self->path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+
+  gsize length = 0;
+  for (;;) {
+    if (length + 1 >= self->buffer_size) {
+      self->buffer_size *= 2;
+      self->buffer = (gchar*)g_realloc(self->buffer, self->buffer_size);
+    }
+    gssize n = read(fd, self->buffer + length, self->buffer_size - length - 1);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      close(fd);
+      return -1;
+    }
+    if (n == 0) break;
+    length += n;
+  }
+  close(fd);
+  self->buffer[length] = '\0';
+  return (gssize)length;
+}
+
+gboolean shm_segments_scan(ShmSegments* self,
+                           ShmSegmentFunc func,
+                           gpointer user_data) {
+  if (read_table(self) < 0) return FALSE;
+
+  // Skip the header line.
+  const gchar* line = strchr(self->buffer, '\n');
+  while (line != NULL && *++line != '\0') {
+    // key shmid perms size cpid lpid nattch ...
+    gchar* p = (gchar*)line;
+    g_ascii_strtoll(p, &p, 10);                 // key
+    g_ascii_strtoll(p, &p, 10);                 // shmid
+    g_ascii_strtoll(p, &p, 10);                 // perms
+    guint64 size = g_ascii_strtoull(p, &p, 10);
+    gint cpid = (gint)g_ascii_strtoll(p, &p, 10);
+    gint lpid = (gint)g_ascii_strtoll(p, &p, 10);
+    guint64 nattch = g_ascii_strtoull(p, &p, 10);
+
+    if (nattch > 0 && is_watched_size(self, size)) {
+      func(cpid, lpid, user_data);
+    }
+    line = strchr(p, '\n');
+  }
+  return TRUE;
+}
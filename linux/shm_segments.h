@@ -0,0 +1,37 @@
+#ifndef SHM_SEGMENTS_H_
+#define SHM_SEGMENTS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Watches the SysV shared memory table (/proc/sysvipc/shm). X11 recorders
+// grab frames through MIT-SHM segments sized exactly like the screen or a
+// monitor (width × height × 4), and the table lists every segment with its
+// creator and last-attach PID — so one read finds capture candidates
+// without walking every process.
+typedef struct _ShmSegments ShmSegments;
+
+// Reports an attached segment of a watched size. |cpid| created it;
+// |lpid| last attached or detached it (for MIT-SHM usually the X server).
+typedef void (*ShmSegmentFunc)(gint cpid, gint lpid, gpointer user_data);
+
+// |path| is normally "/proc/sysvipc/shm" (NULL); other paths are for tests.
+ShmSegments* shm_segments_new(const gchar* path);
+void shm_segments_free(ShmSegments* self);
+
+// Sets the segment sizes, in bytes, that count as a screen frame.
+void shm_segments_set_sizes(ShmSegments* self,
+                            const guint64* sizes,
+                            guint n_sizes);
+gboolean shm_segments_has_sizes(ShmSegments* self);
+
+// Reads the table with a single open() and reports attached segments of a
+// watched size. Returns FALSE if the table could not be read.
+gboolean shm_segments_scan(ShmSegments* self,
+                           ShmSegmentFunc func,
+                           gpointer user_data);
+
+G_END_DECLS
+
+#endif  // SHM_SEGMENTS_H_
@@ -1,100 +1,443 @@
 #include "state_persistence.h"
 
-#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "state_store.h"
+
+// Each application keeps its state in its own StateStore directory, shared
+// by its windows. A window's entry is one key per field, prefixed with the
+// window's role ("role:settings/blur_radius") or, for the main window, "0/".
+// A change appends a small journal record for that window alone and never
+// rewrites the others.
+#define SNAPSHOT_FILE_NAME "state.snapshot"
+#define JOURNAL_FILE_NAME "state.journal"
+#define DEFAULT_APP_ID "default"
+#define MAIN_WINDOW_PREFIX "0/"
+#define ROLE_PREFIX "role:"
+#define APP_ID_CHARS \
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._-"
+
+#define KEY_PREVENT_SCREENSHOT "prevent_screenshot"
+#define KEY_IS_IMAGE_OVERLAY_MODE "is_image_overlay_mode"
+#define KEY_IS_BLUR_OVERLAY_MODE "is_blur_overlay_mode"
+#define KEY_IS_COLOR_OVERLAY_MODE "is_color_overlay_mode"
+#define KEY_BLUR_RADIUS "blur_radius"
+#define KEY_COLOR_VALUE "color_value"
+#define KEY_SCREENSHOT_CURSOR_MS "screenshot_cursor_ms"
+
+// Written by earlier versions; migrated once into the main window's entry,
+// then removed.
+#define LEGACY_FILE_NAME "state.json"
+
+// Opening a store reads its files, so it happens on a worker thread; the
+// windows waiting for it are answered once it is open. A window freed with
+// unsaved fields waits for the open instead, so they are not lost.
+typedef struct {
+  gchar* dir;
+  StateStore* store;  // NULL while opening.
+  guint ref_count;
+  GThread* opener;         // NULL once the open has been taken over.
+  GSource* opened_source;  // Attached by |opener| when it is done.
+  // Written by |opener|, read after it has been joined.
+  StateStore* opened_store;
+  gboolean has_earlier_state;
+  PersistedState earlier_state;
+  GPtrArray* waiters;  // StatePersistence*, waiting for the open.
+  gboolean is_main_entry_taken;
+} SharedStore;
+
+// Store directory → SharedStore*. A store's files take a single writer, so
+// every window of the app goes through one StateStore. Main thread only.
+static GHashTable* shared_stores = NULL;
 
 struct _StatePersistence {
-  gchar* file_path;
+  gchar* store_dir;
+  StateStore* store;  // NULL until loaded.
+  gchar* key_prefix;  // NULL if the window's state is not saved.
+  // Saved before the load; written over the entry once it is read.
+  PersistedState unsaved_state;
+  guint unsaved_fields;
+  StateLoadedCallback loaded_cb;
+  gpointer loaded_user_data;
+  guint loaded_idle_id;
 };
 
-static gchar* get_state_file_path() {
-  return g_build_filename(g_get_user_data_dir(), "no_screenshot", "state.json",
-                          NULL);
-}
-
-StatePersistence* state_persistence_new() {
-  StatePersistence* self = g_new0(StatePersistence, 1);
-  self->file_path = get_state_file_path();
-  return self;
-}
+static const PersistedState kDefaultState = {
+    FALSE, FALSE, FALSE, FALSE, 30.0, (gint)0xFF000000, 0,
+};
 
-void state_persistence_free(StatePersistence* self) {
-  if (self == NULL) return;
-  g_free(self->file_path);
-  g_free(self);
+static gchar* get_state_file_path(const gchar* name) {
+  return g_build_filename(g_get_user_data_dir(), "no_screenshot", name, NULL);
 }
 
-void state_persistence_save(StatePersistence* self,
-                            gboolean prevent_screenshot,
-                            gboolean is_image_overlay_mode,
-                            gboolean is_blur_overlay_mode,
-                            gboolean is_color_overlay_mode,
-                            gdouble blur_radius,
-                            gint color_value) {
-  g_autofree gchar* dir = g_path_get_dirname(self->file_path);
-  g_mkdir_with_parents(dir, 0700);
-
-  g_autofree gchar* json = g_strdup_printf(
-      "{\n"
-      "  \"prevent_screenshot\": %s,\n"
-      "  \"is_image_overlay_mode\": %s,\n"
-      "  \"is_blur_overlay_mode\": %s,\n"
-      "  \"is_color_overlay_mode\": %s,\n"
-      "  \"blur_radius\": %.1f,\n"
-      "  \"color_value\": %d\n"
-      "}\n",
-      prevent_screenshot ? "true" : "false",
-      is_image_overlay_mode ? "true" : "false",
-      is_blur_overlay_mode ? "true" : "false",
-      is_color_overlay_mode ? "true" : "false",
-      blur_radius,
-      color_value);
-
-  g_autoptr(GError) error = NULL;
-  if (!g_file_set_contents(self->file_path, json, -1, &error)) {
-    g_warning("no_screenshot: failed to save state: %s", error->message);
-  }
-}
-
-PersistedState state_persistence_load(StatePersistence* self) {
-  PersistedState state = {FALSE, FALSE, FALSE, FALSE, 30.0, (gint)0xFF000000};
-
+// Reads the state.json of earlier versions. Only used once, for migration.
+static gboolean load_legacy_state(const gchar* file_path,
+                                  PersistedState* state) {
   g_autofree gchar* contents = NULL;
-  g_autoptr(GError) error = NULL;
-
-  if (!g_file_get_contents(self->file_path, &contents, NULL, &error)) {
-    // File doesn't exist yet — return defaults.
-    return state;
-  }
+  if (!g_file_get_contents(file_path, &contents, NULL, NULL)) return FALSE;
 
   // Simple string search — avoids pulling in a full JSON parser.
   if (g_strstr_len(contents, -1, "\"prevent_screenshot\": true") != NULL) {
-    state.prevent_screenshot = TRUE;
+    state->prevent_screenshot = TRUE;
   }
   if (g_strstr_len(contents, -1, "\"is_image_overlay_mode\": true") != NULL) {
-    state.is_image_overlay_mode = TRUE;
+    state->is_image_overlay_mode = TRUE;
   }
   if (g_strstr_len(contents, -1, "\"is_blur_overlay_mode\": true") != NULL) {
-    state.is_blur_overlay_mode = TRUE;
+    state->is_blur_overlay_mode = TRUE;
   }
   if (g_strstr_len(contents, -1, "\"is_color_overlay_mode\": true") != NULL) {
-    state.is_color_overlay_mode = TRUE;
+    state->is_color_overlay_mode = TRUE;
   }
 
   // Extract blur_radius (simple parse after key)
   const gchar* radius_key = "\"blur_radius\": ";
   const gchar* radius_pos = g_strstr_len(contents, -1, radius_key);
   if (radius_pos != NULL) {
-    state.blur_radius = g_ascii_strtod(radius_pos + strlen(radius_key), NULL);
-    if (state.blur_radius <= 0) state.blur_radius = 30.0;
+    state->blur_radius =
+        g_ascii_strtod(radius_pos + strlen(radius_key), NULL);
+    if (state->blur_radius <= 0) state->blur_radius = 30.0;
   }
 
   // Extract color_value (simple parse after key)
   const gchar* color_key = "\"color_value\": ";
   const gchar* color_pos = g_strstr_len(contents, -1, color_key);
   if (color_pos != NULL) {
-    state.color_value = (gint)g_ascii_strtoll(color_pos + strlen(color_key),
-                                              NULL, 10);
+    state->color_value = (gint)g_ascii_strtoll(color_pos + strlen(color_key),
+                                               NULL, 10);
+  }
+
+  // Extract screenshot_cursor_ms (simple parse after key)
+  const gchar* cursor_key = "\"screenshot_cursor_ms\": ";
+  const gchar* cursor_pos = g_strstr_len(contents, -1, cursor_key);
+  if (cursor_pos != NULL) {
+    state->screenshot_cursor_ms =
+        g_ascii_strtoll(cursor_pos + strlen(cursor_key), NULL, 10);
+  }
+  return TRUE;
+}
+
+static void set_field(StateStore* store,
+                      const gchar* prefix,
+                      const gchar* field,
+                      GVariant* value) {
+  g_autofree gchar* key = g_strconcat(prefix, field, NULL);
+  state_store_set(store, key, value);
+}
+
+static void store_state(StateStore* store,
+                        const gchar* prefix,
+                        const PersistedState* state,
+                        guint fields) {
+  if (fields & PERSISTED_PREVENT_SCREENSHOT) {
+    set_field(store, prefix, KEY_PREVENT_SCREENSHOT,
+              g_variant_new_boolean(state->prevent_screenshot));
   }
+  if (fields & PERSISTED_IMAGE_OVERLAY_MODE) {
+    set_field(store, prefix, KEY_IS_IMAGE_OVERLAY_MODE,
+              g_variant_new_boolean(state->is_image_overlay_mode));
+  }
+  if (fields & PERSISTED_BLUR_OVERLAY_MODE) {
+    set_field(store, prefix, KEY_IS_BLUR_OVERLAY_MODE,
+              g_variant_new_boolean(state->is_blur_overlay_mode));
+  }
+  if (fields & PERSISTED_COLOR_OVERLAY_MODE) {
+    set_field(store, prefix, KEY_IS_COLOR_OVERLAY_MODE,
+              g_variant_new_boolean(state->is_color_overlay_mode));
+  }
+  if (fields & PERSISTED_BLUR_RADIUS) {
+    set_field(store, prefix, KEY_BLUR_RADIUS,
+              g_variant_new_double(state->blur_radius));
+  }
+  if (fields & PERSISTED_COLOR_VALUE) {
+    set_field(store, prefix, KEY_COLOR_VALUE,
+              g_variant_new_int32(state->color_value));
+  }
+  if (fields & PERSISTED_SCREENSHOT_CURSOR) {
+    set_field(store, prefix, KEY_SCREENSHOT_CURSOR_MS,
+              g_variant_new_int64(state->screenshot_cursor_ms));
+  }
+}
+
+// Copies the |fields| of |from| into |to|.
+static void copy_fields(PersistedState* to,
+                        const PersistedState* from,
+                        guint fields) {
+  if (fields & PERSISTED_PREVENT_SCREENSHOT) {
+    to->prevent_screenshot = from->prevent_screenshot;
+  }
+  if (fields & PERSISTED_IMAGE_OVERLAY_MODE) {
+    to->is_image_overlay_mode = from->is_image_overlay_mode;
+  }
+  if (fields & PERSISTED_BLUR_OVERLAY_MODE) {
+    to->is_blur_overlay_mode = from->is_blur_overlay_mode;
+  }
+  if (fields & PERSISTED_COLOR_OVERLAY_MODE) {
+    to->is_color_overlay_mode = from->is_color_overlay_mode;
+  }
+  if (fields & PERSISTED_BLUR_RADIUS) to->blur_radius = from->blur_radius;
+  if (fields & PERSISTED_COLOR_VALUE) to->color_value = from->color_value;
+  if (fields & PERSISTED_SCREENSHOT_CURSOR) {
+    to->screenshot_cursor_ms = from->screenshot_cursor_ms;
+  }
+}
+
+// Returns the value of |field| if it has |type|, or NULL.
+static GVariant* lookup(StateStore* store,
+                        const gchar* prefix,
+                        const gchar* field,
+                        const GVariantType* type) {
+  g_autofree gchar* key = g_strconcat(prefix, field, NULL);
+  GVariant* value = state_store_get(store, key);
+  return value != NULL && g_variant_is_of_type(value, type) ? value : NULL;
+}
 
-  return state;
+// Reads the fields stored under |prefix| over |state|. Returns FALSE if
+// there are none.
+static gboolean read_state(StateStore* store,
+                           const gchar* prefix,
+                           PersistedState* state) {
+  gboolean found = FALSE;
+  GVariant* value;
+  if ((value = lookup(store, prefix, KEY_PREVENT_SCREENSHOT,
+                      G_VARIANT_TYPE_BOOLEAN))) {
+    state->prevent_screenshot = g_variant_get_boolean(value);
+    found = TRUE;
+  }
+  if ((value = lookup(store, prefix, KEY_IS_IMAGE_OVERLAY_MODE,
+                      G_VARIANT_TYPE_BOOLEAN))) {
+    state->is_image_overlay_mode = g_variant_get_boolean(value);
+    found = TRUE;
+  }
+  if ((value = lookup(store, prefix, KEY_IS_BLUR_OVERLAY_MODE,
+                      G_VARIANT_TYPE_BOOLEAN))) {
+    state->is_blur_overlay_mode = g_variant_get_boolean(value);
+    found = TRUE;
+  }
+  if ((value = lookup(store, prefix, KEY_IS_COLOR_OVERLAY_MODE,
+                      G_VARIANT_TYPE_BOOLEAN))) {
+    state->is_color_overlay_mode = g_variant_get_boolean(value);
+    found = TRUE;
+  }
+  if ((value = lookup(store, prefix, KEY_BLUR_RADIUS,
+                      G_VARIANT_TYPE_DOUBLE))) {
+    if (g_variant_get_double(value) > 0) {
+      state->blur_radius = g_variant_get_double(value);
+    }
+    found = TRUE;
+  }
+  if ((value = lookup(store, prefix, KEY_COLOR_VALUE,
+                      G_VARIANT_TYPE_INT32))) {
+    state->color_value = g_variant_get_int32(value);
+    found = TRUE;
+  }
+  if ((value = lookup(store, prefix, KEY_SCREENSHOT_CURSOR_MS,
+                      G_VARIANT_TYPE_INT64))) {
+    state->screenshot_cursor_ms = g_variant_get_int64(value);
+    found = TRUE;
+  }
+  return found;
+}
+
+static StateStore* new_store(const gchar* dir) {
+  g_autofree gchar* snapshot_path =
+      g_build_filename(dir, SNAPSHOT_FILE_NAME, NULL);
+  g_autofree gchar* journal_path =
+      g_build_filename(dir, JOURNAL_FILE_NAME, NULL);
+  return state_store_new(snapshot_path, journal_path);
+}
+
+// Reads the state of earlier versions, which becomes the main window's
+// entry. The old files stay until the next launch finds that entry on disk,
+// so a crash before it is written loses nothing.
+static gboolean load_earlier_state(PersistedState* state) {
+  g_autofree gchar* legacy_path = get_state_file_path(LEGACY_FILE_NAME);
+  return load_legacy_state(legacy_path, state);
+}
+
+static void remove_earlier_state() {
+  g_autofree gchar* legacy_path = get_state_file_path(LEGACY_FILE_NAME);
+  g_unlink(legacy_path);
+}
+
+static gpointer open_store_thread(gpointer data) {
+  SharedStore* shared = (SharedStore*)data;
+  shared->opened_store = new_store(shared->dir);
+  if (state_store_is_empty(shared->opened_store)) {
+    shared->earlier_state = kDefaultState;
+    shared->has_earlier_state = load_earlier_state(&shared->earlier_state);
+  } else {
+    remove_earlier_state();
+  }
+  g_source_attach(shared->opened_source, NULL);
+  return NULL;
+}
+
+// Hands the window its entry, with the fields it saved before the load
+// written over it.
+static void report_state(StatePersistence* self, StateStore* store) {
+  self->store = store;
+  PersistedState state = kDefaultState;
+  if (self->key_prefix != NULL) read_state(store, self->key_prefix, &state);
+  copy_fields(&state, &self->unsaved_state, self->unsaved_fields);
+  if (self->key_prefix != NULL) {
+    store_state(store, self->key_prefix, &state, self->unsaved_fields);
+  }
+  self->unsaved_fields = 0;
+  self->loaded_cb(&state, self->loaded_user_data);
+}
+
+static gboolean on_loaded_idle(gpointer user_data) {
+  StatePersistence* self = (StatePersistence*)user_data;
+  self->loaded_idle_id = 0;
+  SharedStore* shared =
+      (SharedStore*)g_hash_table_lookup(shared_stores, self->store_dir);
+  report_state(self, shared->store);
+  return G_SOURCE_REMOVE;
+}
+
+// Waits for the open and installs the store. The waiting windows are
+// answered from the main loop, as one of them may be being freed now.
+static void finish_open(SharedStore* shared) {
+  g_thread_join(shared->opener);
+  shared->opener = NULL;
+  g_source_destroy(shared->opened_source);
+  g_clear_pointer(&shared->opened_source, g_source_unref);
+
+  shared->store = shared->opened_store;
+  shared->opened_store = NULL;
+  if (shared->has_earlier_state) {
+    store_state(shared->store, MAIN_WINDOW_PREFIX, &shared->earlier_state,
+                PERSISTED_ALL_FIELDS);
+  }
+  while (shared->waiters->len > 0) {
+    StatePersistence* waiter =
+        (StatePersistence*)g_ptr_array_steal_index(shared->waiters, 0);
+    waiter->loaded_idle_id = g_idle_add(on_loaded_idle, waiter);
+  }
+}
+
+static gboolean on_store_opened(gpointer user_data) {
+  finish_open((SharedStore*)user_data);
+  return G_SOURCE_REMOVE;
+}
+
+static void shared_store_free(gpointer data) {
+  SharedStore* shared = (SharedStore*)data;
+  // An open cannot be interrupted, but it only reads two small files.
+  if (shared->opener != NULL) finish_open(shared);
+  state_store_free(shared->store);
+  g_ptr_array_unref(shared->waiters);
+  g_free(shared->dir);
+  g_free(shared);
+}
+
+static SharedStore* acquire_store(const gchar* dir) {
+  if (shared_stores == NULL) {
+    shared_stores = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                          shared_store_free);
+  }
+  SharedStore* shared = (SharedStore*)g_hash_table_lookup(shared_stores, dir);
+  if (shared == NULL) {
+    shared = g_new0(SharedStore, 1);
+    shared->dir = g_strdup(dir);
+    shared->waiters = g_ptr_array_new();
+    g_hash_table_insert(shared_stores, g_strdup(dir), shared);
+  }
+  shared->ref_count++;
+  return shared;
+}
+
+static void release_store(const gchar* dir) {
+  SharedStore* shared = (SharedStore*)g_hash_table_lookup(shared_stores, dir);
+  if (--shared->ref_count > 0) {
+    // Other windows keep it open.
+    if (shared->store != NULL) state_store_sync(shared->store);
+    return;
+  }
+  g_hash_table_remove(shared_stores, dir);
+}
+
+// Maps |app_id| to a directory name; anything unusable becomes the default.
+static gchar* get_store_dir(const gchar* app_id) {
+  g_autofree gchar* name =
+      app_id != NULL && app_id[0] != '\0' && app_id[0] != '.'
+          ? g_strcanon(g_strdup(app_id), APP_ID_CHARS, '_')
+          : g_strdup(DEFAULT_APP_ID);
+  return get_state_file_path(name);
+}
+
+StatePersistence* state_persistence_new(const gchar* app_id,
+                                        const gchar* window_role) {
+  StatePersistence* self = g_new0(StatePersistence, 1);
+  self->store_dir = get_store_dir(app_id);
+  SharedStore* shared = acquire_store(self->store_dir);
+  if (window_role != NULL && window_role[0] != '\0') {
+    g_autofree gchar* role =
+        g_strcanon(g_strdup(window_role), APP_ID_CHARS, '_');
+    self->key_prefix = g_strconcat(ROLE_PREFIX, role, "/", NULL);
+  } else if (!shared->is_main_entry_taken) {
+    shared->is_main_entry_taken = TRUE;
+    self->key_prefix = g_strdup(MAIN_WINDOW_PREFIX);
+  }
+  return self;
+}
+
+void state_persistence_free(StatePersistence* self) {
+  if (self == NULL) return;
+  if (self->loaded_idle_id != 0) g_source_remove(self->loaded_idle_id);
+  SharedStore* shared =
+      (SharedStore*)g_hash_table_lookup(shared_stores, self->store_dir);
+  g_ptr_array_remove(shared->waiters, self);
+  if (g_strcmp0(self->key_prefix, MAIN_WINDOW_PREFIX) == 0) {
+    shared->is_main_entry_taken = FALSE;
+  }
+  if (self->unsaved_fields != 0 && self->key_prefix != NULL) {
+    // Freed before its state was reported.
+    if (shared->opener != NULL) finish_open(shared);
+    if (shared->store != NULL) {
+      store_state(shared->store, self->key_prefix, &self->unsaved_state,
+                  self->unsaved_fields);
+    }
+  }
+  release_store(self->store_dir);
+  g_free(self->key_prefix);
+  g_free(self->store_dir);
+  g_free(self);
+}
+
+void state_persistence_load_async(StatePersistence* self,
+                                  StateLoadedCallback cb,
+                                  gpointer user_data) {
+  self->loaded_cb = cb;
+  self->loaded_user_data = user_data;
+
+  SharedStore* shared =
+      (SharedStore*)g_hash_table_lookup(shared_stores, self->store_dir);
+  if (shared->store != NULL) {
+    // Another window opened it already; the entry is in memory.
+    self->loaded_idle_id = g_idle_add(on_loaded_idle, self);
+    return;
+  }
+  g_ptr_array_add(shared->waiters, self);
+  if (shared->opener != NULL) return;  // Opening.
+
+  shared->opened_source = g_idle_source_new();
+  g_source_set_callback(shared->opened_source, on_store_opened, shared, NULL);
+  shared->opener =
+      g_thread_new("no_screenshot-open", open_store_thread, shared);
+}
+
+void state_persistence_save(StatePersistence* self,
+                            const PersistedState* state,
+                            guint fields) {
+  if (self->store == NULL) {
+    // Not loaded yet.
+    copy_fields(&self->unsaved_state, state, fields);
+    self->unsaved_fields |= fields;
+    return;
+  }
+  if (self->key_prefix != NULL) {
+    store_state(self->store, self->key_prefix, state, fields);
+  }
 }
@@ -12,22 +12,60 @@ typedef struct {
   gboolean is_color_overlay_mode;
   gdouble blur_radius;
   gint color_value;
+  // Screenshots modified up to this time (ms since epoch) have been seen;
+  // 0 if screenshot listening never ran.
+  gint64 screenshot_cursor_ms;
 } PersistedState;
 
+// Fields of PersistedState, as a mask of those to save.
+typedef enum {
+  PERSISTED_PREVENT_SCREENSHOT = 1 << 0,
+  PERSISTED_IMAGE_OVERLAY_MODE = 1 << 1,
+  PERSISTED_BLUR_OVERLAY_MODE = 1 << 2,
+  PERSISTED_COLOR_OVERLAY_MODE = 1 << 3,
+  PERSISTED_BLUR_RADIUS = 1 << 4,
+  PERSISTED_COLOR_VALUE = 1 << 5,
+  PERSISTED_SCREENSHOT_CURSOR = 1 << 6,
+} PersistedField;
+
+#define PERSISTED_OVERLAY_MODES                                \
+  (PERSISTED_IMAGE_OVERLAY_MODE | PERSISTED_BLUR_OVERLAY_MODE | \
+   PERSISTED_COLOR_OVERLAY_MODE)
+#define PERSISTED_ALL_FIELDS 0x7f
+
 typedef struct _StatePersistence StatePersistence;
 
-StatePersistence* state_persistence_new();
+// Reports the window's saved state, or defaults for the fields it lacks.
+// Fields saved before the load take precedence over those on disk.
+typedef void (*StateLoadedCallback)(const PersistedState* state,
+                                    gpointer user_data);
+
+// Prepares the state of a window of the application |app_id|, without
+// touching the disk. The windows of an application share its files but each
+// reads and writes only its own entry. A window with a |window_role| (see
+// gtk_window_set_role()) keeps the entry of that role across launches. Of
+// the windows without one, the first open has the main entry; any opened
+// alongside it start from defaults and are not saved.
+StatePersistence* state_persistence_new(const gchar* app_id,
+                                        const gchar* window_role);
 void state_persistence_free(StatePersistence* self);
 
+// Records the |fields| (a PersistedField mask) of |state| in memory; the
+// others keep their saved values. Before the state has loaded the fields are
+// held back and written over it once it does. Fields that changed are
+// appended to the state journal on a background thread shortly afterwards —
+// a burst of changes becomes one write. Freeing writes any pending state,
+// waiting for the load if need be.
 void state_persistence_save(StatePersistence* self,
-                            gboolean prevent_screenshot,
-                            gboolean is_image_overlay_mode,
-                            gboolean is_blur_overlay_mode,
-                            gboolean is_color_overlay_mode,
-                            gdouble blur_radius,
-                            gint color_value);
-
-PersistedState state_persistence_load(StatePersistence* self);
+                            const PersistedState* state,
+                            guint fields);
+
+// Loads the state on a worker thread and reports it from the main loop.
+// Freeing before then cancels the report. On first run after an upgrade, the
+// main window takes over the state of earlier versions.
+void state_persistence_load_async(StatePersistence* self,
+                                  StateLoadedCallback cb,
+                                  gpointer user_data);
 
 G_END_DECLS
 
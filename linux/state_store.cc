@@ -0,0 +1,492 @@
+#include "state_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+// Changes within this window are appended together.
+#define FLUSH_DELAY_MS 500
+// The journal is folded into a new snapshot once it grows past this.
+#define COMPACT_THRESHOLD_BYTES (64 * 1024)
+// Larger records are treated as corruption.
+#define MAX_RECORD_SIZE (64 * 1024)
+
+// The snapshot is a serialized GVariant "(uv)": the format version and, for
+// version 1, "(ua{sv})" — the generation of the journal that continues it,
+// and every key. Values are used in place from the mapped file.
+#define SNAPSHOT_FORMAT_VERSION 1
+#define SNAPSHOT_FILE_TYPE "(uv)"
+#define SNAPSHOT_TYPE "(ua{sv})"
+
+// The journal starts with a JournalHeader, followed by records: a
+// RecordHeader, then a serialized "(sv)" padded to 8 bytes so every
+// payload stays aligned in the mapped file. A journal whose generation
+// differs from the snapshot's predates the last compaction and is ignored.
+#define JOURNAL_MAGIC 0x314a534eu  // "NSJ1"
+#define RECORD_TYPE "(sv)"
+#define RECORD_ALIGNMENT 8
+
+typedef struct {
+  guint32 magic;
+  guint32 generation;
+} JournalHeader;
+
+typedef struct {
+  guint32 size;  // Of the payload, without padding.
+  guint32 crc;   // CRC-32 of the payload.
+} RecordHeader;
+
+// The files have a single writer: the process holding an exclusive flock()
+// on their directory. Another process — a second copy of the app — opens
+// them read-only. Files are never truncated in place, as a reader may have
+// them mapped; the writer replaces them by rename instead.
+struct _StateStore {
+  gchar* snapshot_path;
+  gchar* journal_path;
+  int lock_fd;  // The directory, locked while we are the writer.
+  gboolean is_read_only;
+
+  // Main thread only.
+  GHashTable* values;   // key → GVariant*
+  GHashTable* changes;  // key → GVariant*, waiting for the flush timer
+  guint flush_timer_id;
+
+  // Shared with the writer thread.
+  GMutex mutex;
+  GCond cond;
+  GHashTable* pending;  // key → GVariant*, not yet picked up by the writer
+  gboolean is_writing;
+  gboolean is_closing;
+  GThread* writer;
+
+  // The writer's view of the files. Set up by the load, then owned by the
+  // writer thread.
+  GHashTable* durable;  // key → GVariant*, as the files hold them
+  guint32 generation;
+  int journal_fd;
+  gsize journal_size;  // Valid bytes; 0 if the journal must be recreated.
+  gboolean has_torn_tail;  // Invalid bytes follow; compact before appending.
+};
+
+static GHashTable* new_value_table() {
+  return g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                               (GDestroyNotify)g_variant_unref);
+}
+
+// Bitwise CRC-32 (IEEE). Records are tiny, so a table buys nothing.
+static guint32 crc32(const guint8* data, gsize size) {
+  guint32 crc = 0xffffffffu;
+  for (gsize i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+static gsize pad_record(gsize size) {
+  return (size + RECORD_ALIGNMENT - 1) & ~(gsize)(RECORD_ALIGNMENT - 1);
+}
+
+// ---------------------------------------------------------------------------
+// Loading
+// ---------------------------------------------------------------------------
+
+static GBytes* map_file(const gchar* path) {
+  GMappedFile* mapped = g_mapped_file_new(path, FALSE, NULL);
+  if (mapped == NULL) return NULL;
+  GBytes* bytes = g_mapped_file_get_bytes(mapped);
+  g_mapped_file_unref(mapped);  // |bytes| keeps the mapping.
+  return bytes;
+}
+
+static void load_snapshot(StateStore* self) {
+  GBytes* bytes = map_file(self->snapshot_path);
+  if (bytes == NULL) return;
+
+  GVariant* file = g_variant_ref_sink(g_variant_new_from_bytes(
+      G_VARIANT_TYPE(SNAPSHOT_FILE_TYPE), bytes, FALSE));
+  g_bytes_unref(bytes);
+  guint32 version = 0;
+  GVariant* snapshot = NULL;
+  g_variant_get(file, SNAPSHOT_FILE_TYPE, &version, &snapshot);
+  g_variant_unref(file);
+
+  if (version == SNAPSHOT_FORMAT_VERSION &&
+      g_variant_is_of_type(snapshot, G_VARIANT_TYPE(SNAPSHOT_TYPE))) {
+    GVariant* entries = g_variant_get_child_value(snapshot, 1);
+    g_variant_get_child(snapshot, 0, "u", &self->generation);
+    gsize n = g_variant_n_children(entries);
+    for (gsize i = 0; i < n; i++) {
+      const gchar* key = NULL;
+      GVariant* value = NULL;
+      g_variant_get_child(entries, i, "{&sv}", &key, &value);
+      g_hash_table_replace(self->durable, g_strdup(key), value);
+    }
+    g_variant_unref(entries);
+  } else {
+    g_warning("no_screenshot: unreadable state snapshot, ignoring it");
+  }
+  g_variant_unref(snapshot);
+}
+
+// Replays the journal onto |durable| and records how much of it is valid.
+static void replay_journal(StateStore* self) {
+  GBytes* bytes = map_file(self->journal_path);
+  if (bytes == NULL) return;
+
+  gsize size = 0;
+  const guint8* data = (const guint8*)g_bytes_get_data(bytes, &size);
+  JournalHeader header;
+  if (size < sizeof(header)) {
+    g_bytes_unref(bytes);
+    return;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != JOURNAL_MAGIC || header.generation != self->generation) {
+    g_bytes_unref(bytes);  // Stale or foreign; recreated on first write.
+    return;
+  }
+
+  gsize offset = sizeof(header);
+  while (offset + sizeof(RecordHeader) <= size) {
+    RecordHeader record;
+    memcpy(&record, data + offset, sizeof(record));
+    gsize payload = offset + sizeof(record);
+    if (record.size == 0 || record.size > MAX_RECORD_SIZE ||
+        payload + pad_record(record.size) > size ||
+        crc32(data + payload, record.size) != record.crc) {
+      break;  // A torn or corrupt tail ends the valid journal.
+    }
+
+    GBytes* record_bytes = g_bytes_new_from_bytes(bytes, payload, record.size);
+    GVariant* entry = g_variant_ref_sink(g_variant_new_from_bytes(
+        G_VARIANT_TYPE(RECORD_TYPE), record_bytes, FALSE));
+    g_bytes_unref(record_bytes);
+    const gchar* key = NULL;
+    GVariant* value = NULL;
+    g_variant_get(entry, "(&sv)", &key, &value);
+    if (key[0] != '\0') {
+      g_hash_table_replace(self->durable, g_strdup(key), value);
+    } else {
+      g_variant_unref(value);
+    }
+    g_variant_unref(entry);
+    offset = payload + pad_record(record.size);
+  }
+
+  if (offset < size) {
+    g_warning("no_screenshot: state journal damaged after %" G_GSIZE_FORMAT
+              " bytes, dropping the rest",
+              offset);
+  }
+  self->journal_size = offset;
+  self->has_torn_tail = offset < size;
+  g_bytes_unref(bytes);
+}
+
+// ---------------------------------------------------------------------------
+// Writer thread
+// ---------------------------------------------------------------------------
+
+static gboolean write_all(int fd, const guint8* data, gsize size) {
+  while (size > 0) {
+    ssize_t n = write(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return FALSE;
+    data += n;
+    size -= n;
+  }
+  return TRUE;
+}
+
+// Opens the journal for appending. A journal with no valid part is replaced
+// by a fresh one rather than truncated.
+static gboolean open_journal(StateStore* self) {
+  if (self->journal_fd >= 0) return TRUE;
+
+  if (self->journal_size == 0) {
+    JournalHeader header = {JOURNAL_MAGIC, self->generation};
+    g_autofree gchar* dir = g_path_get_dirname(self->journal_path);
+    g_mkdir_with_parents(dir, 0700);
+    g_autoptr(GError) error = NULL;
+    if (!g_file_set_contents(self->journal_path, (const gchar*)&header,
+                             sizeof(header), &error)) {
+      g_warning("no_screenshot: failed to save state: %s", error->message);
+      return FALSE;
+    }
+    self->journal_size = sizeof(header);
+  }
+
+  int fd = open(self->journal_path, O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (fd < 0) return FALSE;
+  self->journal_fd = fd;
+  return TRUE;
+}
+
+// Writes every durable key into a new snapshot under the next generation,
+// then restarts the journal. A crash in between leaves a journal of the old
+// generation, which the next load ignores.
+static gboolean compact(StateStore* self) {
+  GVariantBuilder entries;
+  g_variant_builder_init(&entries, G_VARIANT_TYPE("a{sv}"));
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->durable);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    g_variant_builder_add(&entries, "{sv}", (const gchar*)key,
+                          (GVariant*)value);
+  }
+  guint32 generation = self->generation + 1;
+  GVariant* file = g_variant_ref_sink(g_variant_new(
+      SNAPSHOT_FILE_TYPE, (guint32)SNAPSHOT_FORMAT_VERSION,
+      g_variant_new(SNAPSHOT_TYPE, generation, &entries)));
+
+  g_autofree gchar* dir = g_path_get_dirname(self->snapshot_path);
+  g_mkdir_with_parents(dir, 0700);
+  g_autoptr(GError) error = NULL;
+  gboolean ok = g_file_set_contents(
+      self->snapshot_path, (const gchar*)g_variant_get_data(file),
+      (gssize)g_variant_get_size(file), &error);
+  g_variant_unref(file);
+  if (!ok) {
+    g_warning("no_screenshot: failed to save state: %s", error->message);
+    return FALSE;
+  }
+
+  self->generation = generation;
+  self->journal_size = 0;
+  self->has_torn_tail = FALSE;
+  if (self->journal_fd >= 0) {
+    close(self->journal_fd);
+    self->journal_fd = -1;
+  }
+  open_journal(self);
+  return TRUE;
+}
+
+// Appends one record per changed key in a single write. Behind a torn tail
+// the batch goes into a new snapshot instead.
+static void append_batch(StateStore* self, GHashTable* batch) {
+  GByteArray* buffer = g_byte_array_new();
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, batch);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    GVariant* entry = g_variant_ref_sink(
+        g_variant_new(RECORD_TYPE, (const gchar*)key, (GVariant*)value));
+    RecordHeader record;
+    record.size = (guint32)g_variant_get_size(entry);
+    const guint8* payload = (const guint8*)g_variant_get_data(entry);
+    record.crc = crc32(payload, record.size);
+    static const guint8 kPadding[RECORD_ALIGNMENT] = {0};
+    g_byte_array_append(buffer, (const guint8*)&record, sizeof(record));
+    g_byte_array_append(buffer, payload, record.size);
+    g_byte_array_append(buffer, kPadding,
+                        pad_record(record.size) - record.size);
+    g_variant_unref(entry);
+
+    g_hash_table_replace(self->durable, g_strdup((const gchar*)key),
+                         g_variant_ref((GVariant*)value));
+  }
+
+  if (self->has_torn_tail) {
+    g_byte_array_unref(buffer);
+    compact(self);
+    return;
+  }
+  gboolean ok = open_journal(self) &&
+                write_all(self->journal_fd, buffer->data, buffer->len);
+  if (ok) self->journal_size += buffer->len;
+  g_byte_array_unref(buffer);
+  if (ok) {
+    if (self->journal_size > COMPACT_THRESHOLD_BYTES) compact(self);
+    return;
+  }
+
+  // A failed append may have left part of a record behind; a snapshot of
+  // everything makes the state whole again. Until one succeeds, the journal
+  // is treated as torn so nothing is appended after that part.
+  if (!compact(self)) {
+    self->has_torn_tail = TRUE;
+    if (self->journal_fd >= 0) {
+      close(self->journal_fd);
+      self->journal_fd = -1;
+    }
+  }
+}
+
+static gpointer writer_thread(gpointer user_data) {
+  StateStore* self = (StateStore*)user_data;
+  g_mutex_lock(&self->mutex);
+  for (;;) {
+    while (g_hash_table_size(self->pending) == 0 && !self->is_closing) {
+      g_cond_wait(&self->cond, &self->mutex);
+    }
+    if (g_hash_table_size(self->pending) == 0) break;  // Closing.
+
+    GHashTable* batch = self->pending;
+    self->pending = new_value_table();
+    self->is_writing = TRUE;
+    g_mutex_unlock(&self->mutex);
+    append_batch(self, batch);
+    g_hash_table_unref(batch);
+    g_mutex_lock(&self->mutex);
+    self->is_writing = FALSE;
+    g_cond_broadcast(&self->cond);
+  }
+  g_mutex_unlock(&self->mutex);
+  return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Main thread
+// ---------------------------------------------------------------------------
+
+// Moves the collected changes to the writer, starting it on first use.
+static void hand_off(StateStore* self) {
+  g_mutex_lock(&self->mutex);
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->changes);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    g_hash_table_replace(self->pending, key, value);
+    g_hash_table_iter_steal(&iter);
+  }
+  g_cond_broadcast(&self->cond);
+  g_mutex_unlock(&self->mutex);
+
+  if (self->writer == NULL) {
+    self->writer = g_thread_new("no_screenshot-state", writer_thread, self);
+  }
+}
+
+// Hands pending changes to the writer now instead of after the delay.
+static void flush_pending(StateStore* self) {
+  if (self->flush_timer_id == 0) return;
+  g_source_remove(self->flush_timer_id);
+  self->flush_timer_id = 0;
+  hand_off(self);
+}
+
+static gboolean on_flush_timer(gpointer user_data) {
+  StateStore* self = (StateStore*)user_data;
+  self->flush_timer_id = 0;
+  hand_off(self);
+  return G_SOURCE_REMOVE;
+}
+
+// Takes the writer lock on the directory of the files. Returns FALSE if
+// another process holds it.
+static gboolean lock_files(StateStore* self) {
+  g_autofree gchar* dir = g_path_get_dirname(self->snapshot_path);
+  g_mkdir_with_parents(dir, 0700);
+  self->lock_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (self->lock_fd < 0) return TRUE;  // Nothing to write to anyway.
+  if (flock(self->lock_fd, LOCK_EX | LOCK_NB) == 0 || errno != EWOULDBLOCK) {
+    return TRUE;  // Locked, or the filesystem has no locks.
+  }
+  close(self->lock_fd);
+  self->lock_fd = -1;
+  return FALSE;
+}
+
+StateStore* state_store_new(const gchar* snapshot_path,
+                            const gchar* journal_path) {
+  StateStore* self = g_new0(StateStore, 1);
+  self->snapshot_path = g_strdup(snapshot_path);
+  self->journal_path = g_strdup(journal_path);
+  if (!lock_files(self)) {
+    self->is_read_only = TRUE;
+    g_message("no_screenshot: %s is in use by another process, changes "
+              "will not be saved",
+              snapshot_path);
+  }
+  self->changes = new_value_table();
+  self->pending = new_value_table();
+  self->durable = new_value_table();
+  self->journal_fd = -1;
+  g_mutex_init(&self->mutex);
+  g_cond_init(&self->cond);
+
+  load_snapshot(self);
+  replay_journal(self);
+
+  self->values = new_value_table();
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->durable);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    g_hash_table_insert(self->values, g_strdup((const gchar*)key),
+                        g_variant_ref((GVariant*)value));
+  }
+  return self;
+}
+
+void state_store_free(StateStore* self) {
+  if (self == NULL) return;
+  flush_pending(self);
+  if (self->writer != NULL) {
+    g_mutex_lock(&self->mutex);
+    self->is_closing = TRUE;
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->mutex);
+    g_thread_join(self->writer);
+  }
+  if (self->journal_fd >= 0) close(self->journal_fd);
+  if (self->lock_fd >= 0) close(self->lock_fd);
+  g_mutex_clear(&self->mutex);
+  g_cond_clear(&self->cond);
+  g_hash_table_unref(self->changes);
+  g_hash_table_unref(self->pending);
+  g_hash_table_unref(self->durable);
+  g_hash_table_unref(self->values);
+  g_free(self->journal_path);
+  g_free(self->snapshot_path);
+  g_free(self);
+}
+
+gboolean state_store_is_empty(StateStore* self) {
+  return g_hash_table_size(self->values) == 0;
+}
+
+GVariant* state_store_get(StateStore* self, const gchar* key) {
+  return (GVariant*)g_hash_table_lookup(self->values, key);
+}
+
+void state_store_set(StateStore* self, const gchar* key, GVariant* value) {
+  g_variant_ref_sink(value);
+  GVariant* current = (GVariant*)g_hash_table_lookup(self->values, key);
+  if (current != NULL && g_variant_equal(current, value)) {
+    g_variant_unref(value);
+    return;
+  }
+  g_hash_table_replace(self->values, g_strdup(key), g_variant_ref(value));
+  if (self->is_read_only) {
+    g_variant_unref(value);
+    return;
+  }
+  g_hash_table_replace(self->changes, g_strdup(key), value);
+
+  if (self->flush_timer_id == 0) {
+    self->flush_timer_id =
+        g_timeout_add(FLUSH_DELAY_MS, on_flush_timer, self);
+  }
+}
+
+void state_store_sync(StateStore* self) {
+  flush_pending(self);
+  g_mutex_lock(&self->mutex);
+  while (self->writer != NULL &&
+         (g_hash_table_size(self->pending) > 0 || self->is_writing)) {
+    g_cond_wait(&self->cond, &self->mutex);
+  }
+  g_mutex_unlock(&self->mutex);
+}
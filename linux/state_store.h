@@ -0,0 +1,40 @@
+#ifndef STATE_STORE_H_
+#define STATE_STORE_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Persistent key → GVariant store backed by a snapshot and an append-only
+// journal. Each change is a small checksummed record appended by a
+// background writer; when the journal grows past a threshold it is
+// compacted into a new snapshot. Loading maps the snapshot and replays the
+// journal up to the last valid record, so a torn write at a crash loses at
+// most that record. Only one process writes the files; in any other, the
+// store is read-only and changes stay in memory.
+typedef struct _StateStore StateStore;
+
+// Opens the store at |snapshot_path| and |journal_path|, which must share a
+// directory, and loads it.
+StateStore* state_store_new(const gchar* snapshot_path,
+                            const gchar* journal_path);
+// Writes any pending changes and waits for them.
+void state_store_free(StateStore* self);
+
+// Returns TRUE if the store holds no keys, e.g. on first run.
+gboolean state_store_is_empty(StateStore* self);
+
+// Returns the value of |key| (owned by the store), or NULL.
+GVariant* state_store_get(StateStore* self, const gchar* key);
+
+// Sets |key| to |value|, sinking a floating reference. An unchanged value
+// is ignored; changes made close together are appended as one write
+// shortly afterwards.
+void state_store_set(StateStore* self, const gchar* key, GVariant* value);
+
+// Writes pending changes now and waits until they are on disk.
+void state_store_sync(StateStore* self);
+
+G_END_DECLS
+
+#endif  // STATE_STORE_H_
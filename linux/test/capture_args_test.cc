@@ -0,0 +1,102 @@
+#include <glib.h>
+#include <string.h>
+
+#include "capture_args.h"
+
+// Classifies command lines as /proc/<pid>/cmdline holds them. The v4l2
+// loopback cases need a v4l2loopback device and are skipped without one.
+
+// Checks |command|, whose arguments are separated by single spaces.
+static gboolean is_screen_capture(const gchar* command, const gchar* cwd) {
+  g_autofree gchar* argv = g_strdup(command);
+  gsize length = strlen(argv) + 1;  // cmdline ends with a NUL too.
+  for (gchar* c = argv; *c != '\0'; c++) {
+    if (*c == ' ') *c = '\0';
+  }
+  return capture_args_is_screen_capture(argv, length, cwd);
+}
+
+// Returns the name ("videoN") of a v4l2loopback device, or NULL.
+static gchar* find_loopback_device() {
+  GDir* dir = g_dir_open("/sys/class/video4linux", 0, NULL);
+  if (dir == NULL) return NULL;
+  gchar* name = NULL;
+  const gchar* entry;
+  while (name == NULL && (entry = g_dir_read_name(dir)) != NULL) {
+    g_autofree gchar* path = g_build_filename("/dev", entry, NULL);
+    if (capture_args_is_loopback_device(path)) name = g_strdup(entry);
+  }
+  g_dir_close(dir);
+  return name;
+}
+
+static void test_screen_grab() {
+  g_assert_true(is_screen_capture(
+      "ffmpeg -video_size 1920x1080 -f x11grab -i :0.0 out.mp4", NULL));
+  g_assert_true(is_screen_capture(
+      "ffmpeg -device /dev/dri/card0 -f kmsgrab -i - out.mkv", NULL));
+
+  // An argv cut off after -i holds no input.
+  g_assert_false(is_screen_capture("ffmpeg -f x11grab -i", NULL));
+}
+
+static void test_transcode() {
+  g_assert_false(is_screen_capture(
+      "ffmpeg -i in.mp4 -c:v libx264 -f mp4 out.mp4", NULL));
+  // Output options look like input ones; only an -i makes an input.
+  g_assert_false(
+      is_screen_capture("ffmpeg -i in.mp4 -f x11grab out.mp4", NULL));
+  g_assert_false(is_screen_capture("ffmpeg -f x11grab", NULL));
+}
+
+static void test_multiple_inputs() {
+  // A screen grab overlaid on a video.
+  g_assert_true(is_screen_capture(
+      "ffmpeg -i in.mp4 -f x11grab -i :0 -filter_complex overlay out.mp4",
+      NULL));
+
+  // -f applies to the next -i only.
+  g_assert_false(is_screen_capture(
+      "ffmpeg -f pulse -i default -i in.mp4 -f x11grab out.mp4", NULL));
+  g_assert_false(is_screen_capture(
+      "ffmpeg -f lavfi -i testsrc -f v4l2 -i /dev/null out.mp4", NULL));
+}
+
+static void test_v4l2() {
+  // Not video devices.
+  g_assert_false(is_screen_capture("ffmpeg -f v4l2 -i /dev/null out", "/"));
+  g_assert_false(is_screen_capture("ffmpeg -f v4l2 -i dev/null out", "/"));
+
+  g_autofree gchar* device = find_loopback_device();
+  if (device == NULL) {
+    g_test_skip("no v4l2loopback device");
+    return;
+  }
+  g_autofree gchar* path = g_build_filename("/dev", device, NULL);
+
+  // Reading from a loopback device is capturing what its producer sends,
+  // while writing to one is feeding it.
+  g_autofree gchar* input =
+      g_strdup_printf("ffmpeg -f v4l2 -i %s out.mp4", path);
+  g_autofree gchar* output =
+      g_strdup_printf("ffmpeg -re -i in.mp4 -f v4l2 %s", path);
+  g_assert_true(is_screen_capture(input, NULL));
+  g_assert_false(is_screen_capture(output, NULL));
+
+  // Relative inputs count from the process's working directory only.
+  g_autofree gchar* relative =
+      g_strdup_printf("ffmpeg -f video4linux2 -i %s out.mp4", device);
+  g_assert_true(is_screen_capture(relative, "/dev"));
+  g_assert_false(is_screen_capture(relative, "/"));
+  g_assert_false(is_screen_capture(relative, NULL));
+  g_assert_false(capture_args_is_loopback_device(device));
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  g_test_add_func("/capture_args/screen-grab", test_screen_grab);
+  g_test_add_func("/capture_args/transcode", test_transcode);
+  g_test_add_func("/capture_args/multiple-inputs", test_multiple_inputs);
+  g_test_add_func("/capture_args/v4l2", test_v4l2);
+  return g_test_run();
+}
@@ -0,0 +1,379 @@
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <pipewire/pipewire.h>
+#include <signal.h>
+#include <spa/param/video/format-utils.h>
+#include <sys/wait.h>
+
+#include "pipewire_monitor.h"
+#include "test/test_util.h"
+
+// Runs a private PipeWire daemon with just the modules streams and links
+// need, so the test neither needs nor disturbs the session's daemon. Skipped
+// when the pipewire binary is not installed.
+#define REMOTE_NAME "no-screenshot-test"
+// Covers the monitor's first reconnection attempts after a restart.
+#define WAIT_TIMEOUT_MS 10000
+
+static const gchar kDaemonConfig[] =
+    "context.properties = {\n"
+    "  core.daemon = true\n"
+    "  core.name = " REMOTE_NAME "\n"
+    "  support.dbus = false\n"
+    "}\n"
+    "context.spa-libs = {\n"
+    "  audio.convert.* = audioconvert/libspa-audioconvert\n"
+    "  video.convert.* = videoconvert/libspa-videoconvert\n"
+    "  support.* = support/libspa-support\n"
+    "}\n"
+    "context.modules = [\n"
+    "  { name = libpipewire-module-protocol-native }\n"
+    "  { name = libpipewire-module-client-node }\n"
+    "  { name = libpipewire-module-adapter }\n"
+    "  { name = libpipewire-module-link-factory }\n"
+    "]\n";
+
+typedef struct {
+  guint32 node_id;
+  gboolean is_active;
+  guint n_changes;
+} CaptureRecord;
+
+typedef struct {
+  gchar* runtime_dir;
+  gchar* config_path;
+  gchar* socket_path;
+  GPid daemon_pid;
+
+  // The streams live on their own thread, like in a real producer and
+  // consumer; the monitor runs on the GLib main loop.
+  pw_thread_loop* loop;
+  pw_context* context;
+  pw_core* core;
+
+  PipeWireMonitor* monitor;
+  GArray* records;  // CaptureRecord per reported node.
+  guint32 expected_node;  // What is_capture_active/ended look at.
+} Fixture;
+
+typedef struct {
+  pw_stream* stream;
+  spa_hook listener;
+} TestStream;
+
+static void on_capture_changed(guint32 node_id,
+                               const gchar* app_name,
+                               gint pid,
+                               gboolean is_active,
+                               gpointer user_data) {
+  GArray* records = (GArray*)user_data;
+  for (guint i = 0; i < records->len; i++) {
+    CaptureRecord* record = &g_array_index(records, CaptureRecord, i);
+    if (record->node_id != node_id) continue;
+    record->is_active = is_active;
+    record->n_changes++;
+    return;
+  }
+  CaptureRecord record = {node_id, is_active, 1};
+  g_array_append_val(records, record);
+}
+
+static const CaptureRecord* find_record(GArray* records, guint32 node_id) {
+  for (guint i = 0; i < records->len; i++) {
+    const CaptureRecord* record = &g_array_index(records, CaptureRecord, i);
+    if (record->node_id == node_id) return record;
+  }
+  return NULL;
+}
+
+static gboolean is_capture_active(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  const CaptureRecord* record =
+      find_record(fixture->records, fixture->expected_node);
+  return record != NULL && record->is_active;
+}
+
+static gboolean is_capture_ended(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  const CaptureRecord* record =
+      find_record(fixture->records, fixture->expected_node);
+  return record != NULL && !record->is_active;
+}
+
+static gboolean is_socket_present(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  return g_file_test(fixture->socket_path, G_FILE_TEST_EXISTS);
+}
+
+static void start_daemon(Fixture* fixture) {
+  // Its events wake test_wait_until() when the socket appears.
+  g_autoptr(GFile) dir = g_file_new_for_path(fixture->runtime_dir);
+  g_autoptr(GFileMonitor) dir_monitor =
+      g_file_monitor_directory(dir, G_FILE_MONITOR_NONE, NULL, NULL);
+
+  g_autofree gchar* daemon = g_find_program_in_path("pipewire");
+  const gchar* argv[] = {daemon, "-c", fixture->config_path, NULL};
+  g_autoptr(GError) error = NULL;
+  g_spawn_async(NULL, (gchar**)argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD, NULL,
+                NULL, &fixture->daemon_pid, &error);
+  g_assert_no_error(error);
+  g_assert_true(test_wait_until(is_socket_present, fixture, WAIT_TIMEOUT_MS));
+}
+
+static void stop_daemon(Fixture* fixture) {
+  kill(fixture->daemon_pid, SIGTERM);
+  waitpid(fixture->daemon_pid, NULL, 0);
+  g_spawn_close_pid(fixture->daemon_pid);
+}
+
+static void connect_client(Fixture* fixture) {
+  pw_thread_loop_lock(fixture->loop);
+  fixture->core = pw_context_connect(
+      fixture->context, pw_properties_new(PW_KEY_REMOTE_NAME, REMOTE_NAME,
+                                          NULL),
+      0);
+  pw_thread_loop_unlock(fixture->loop);
+  g_assert_nonnull(fixture->core);
+}
+
+static void disconnect_client(Fixture* fixture) {
+  pw_thread_loop_lock(fixture->loop);
+  pw_core_disconnect(fixture->core);
+  pw_thread_loop_unlock(fixture->loop);
+}
+
+static void fixture_setup(Fixture* fixture, gconstpointer data) {
+  fixture->runtime_dir = g_dir_make_tmp("pipewire_monitor_test-XXXXXX", NULL);
+  g_assert_nonnull(fixture->runtime_dir);
+  fixture->config_path =
+      g_build_filename(fixture->runtime_dir, "pipewire.conf", NULL);
+  fixture->socket_path =
+      g_build_filename(fixture->runtime_dir, REMOTE_NAME, NULL);
+  g_assert_true(
+      g_file_set_contents(fixture->config_path, kDaemonConfig, -1, NULL));
+
+  // Clients in this process find the daemon's socket through the same
+  // variable.
+  g_setenv("PIPEWIRE_RUNTIME_DIR", fixture->runtime_dir, TRUE);
+  start_daemon(fixture);
+
+  pw_init(NULL, NULL);
+  fixture->loop = pw_thread_loop_new("pipewire_monitor_test", NULL);
+  fixture->context =
+      pw_context_new(pw_thread_loop_get_loop(fixture->loop), NULL, 0);
+  pw_thread_loop_start(fixture->loop);
+  connect_client(fixture);
+
+  fixture->records = g_array_new(FALSE, FALSE, sizeof(CaptureRecord));
+  fixture->monitor =
+      pipewire_monitor_new(REMOTE_NAME, on_capture_changed, fixture->records);
+  pipewire_monitor_start(fixture->monitor);
+}
+
+static void fixture_teardown(Fixture* fixture, gconstpointer data) {
+  pipewire_monitor_free(fixture->monitor);
+  g_array_unref(fixture->records);
+
+  disconnect_client(fixture);
+  pw_thread_loop_stop(fixture->loop);
+  pw_context_destroy(fixture->context);
+  pw_thread_loop_destroy(fixture->loop);
+  stop_daemon(fixture);
+
+  g_unlink(fixture->config_path);
+  g_rmdir(fixture->runtime_dir);
+  g_free(fixture->socket_path);
+  g_free(fixture->config_path);
+  g_free(fixture->runtime_dir);
+}
+
+// Streams change state, and get their node id, on the PipeWire thread.
+static void on_stream_state_changed(void* data,
+                                    pw_stream_state old_state,
+                                    pw_stream_state state,
+                                    const char* error) {
+  g_main_context_wakeup(NULL);
+}
+
+static const pw_stream_events kStreamEvents = {
+    PW_VERSION_STREAM_EVENTS,
+    NULL,  // destroy
+    on_stream_state_changed,
+};
+
+// Connects a video stream; |media_class| and |role| may be NULL for the
+// defaults of a plain consumer.
+static TestStream* connect_stream(Fixture* fixture,
+                                  const gchar* node_name,
+                                  const gchar* media_class,
+                                  const gchar* role,
+                                  spa_direction direction) {
+  pw_properties* props =
+      pw_properties_new(PW_KEY_MEDIA_TYPE, "Video", PW_KEY_NODE_NAME,
+                        node_name, NULL);
+  if (media_class != NULL) {
+    pw_properties_set(props, PW_KEY_MEDIA_CLASS, media_class);
+  }
+  if (role != NULL) pw_properties_set(props, PW_KEY_MEDIA_ROLE, role);
+
+  uint8_t buffer[1024];
+  spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+  spa_video_info_raw info = {};
+  info.format = SPA_VIDEO_FORMAT_BGRx;
+  info.size.width = 320;
+  info.size.height = 240;
+  info.framerate.num = 30;
+  info.framerate.denom = 1;
+  const spa_pod* params[] = {
+      spa_format_video_raw_build(&builder, SPA_PARAM_EnumFormat, &info)};
+
+  TestStream* stream = g_new0(TestStream, 1);
+  pw_thread_loop_lock(fixture->loop);
+  stream->stream = pw_stream_new(fixture->core, node_name, props);
+  pw_stream_add_listener(stream->stream, &stream->listener, &kStreamEvents,
+                         NULL);
+  pw_stream_connect(
+      stream->stream, direction, PW_ID_ANY,
+      direction == PW_DIRECTION_OUTPUT ? PW_STREAM_FLAG_DRIVER
+                                       : PW_STREAM_FLAG_NONE,
+      params, G_N_ELEMENTS(params));
+  pw_thread_loop_unlock(fixture->loop);
+  return stream;
+}
+
+typedef struct {
+  Fixture* fixture;
+  TestStream* stream;
+  guint32 node_id;
+} StreamRef;
+
+static gboolean has_node_id(gpointer user_data) {
+  StreamRef* ref = (StreamRef*)user_data;
+  pw_thread_loop_lock(ref->fixture->loop);
+  ref->node_id = pw_stream_get_node_id(ref->stream->stream);
+  pw_thread_loop_unlock(ref->fixture->loop);
+  return ref->node_id != SPA_ID_INVALID;
+}
+
+static guint32 wait_for_node_id(Fixture* fixture, TestStream* stream) {
+  StreamRef ref = {fixture, stream, SPA_ID_INVALID};
+  g_assert_true(test_wait_until(has_node_id, &ref, WAIT_TIMEOUT_MS));
+  return ref.node_id;
+}
+
+// Links the streams directly, as a session manager would.
+static pw_proxy* link_nodes(Fixture* fixture,
+                            guint32 output_node,
+                            guint32 input_node) {
+  g_autofree gchar* output = g_strdup_printf("%u", output_node);
+  g_autofree gchar* input = g_strdup_printf("%u", input_node);
+  pw_properties* props =
+      pw_properties_new(PW_KEY_LINK_OUTPUT_NODE, output,
+                        PW_KEY_LINK_INPUT_NODE, input, NULL);
+  pw_thread_loop_lock(fixture->loop);
+  pw_proxy* link = (pw_proxy*)pw_core_create_object(
+      fixture->core, "link-factory", PW_TYPE_INTERFACE_Link, PW_VERSION_LINK,
+      &props->dict, 0);
+  pw_thread_loop_unlock(fixture->loop);
+  pw_properties_free(props);
+  g_assert_nonnull(link);
+  return link;
+}
+
+static void destroy_stream(Fixture* fixture, TestStream* stream) {
+  pw_thread_loop_lock(fixture->loop);
+  spa_hook_remove(&stream->listener);
+  pw_stream_destroy(stream->stream);
+  pw_thread_loop_unlock(fixture->loop);
+  g_free(stream);
+}
+
+static void destroy_link(Fixture* fixture, pw_proxy* link) {
+  pw_thread_loop_lock(fixture->loop);
+  pw_proxy_destroy(link);
+  pw_thread_loop_unlock(fixture->loop);
+}
+
+static void test_screencast_not_camera(Fixture* fixture, gconstpointer data) {
+  // A camera has the same media class as a portal screencast.
+  TestStream* camera = connect_stream(fixture, "test-camera", "Video/Source",
+                                      "Camera", PW_DIRECTION_OUTPUT);
+  TestStream* screencast = connect_stream(
+      fixture, "xdpw_stream", "Video/Source", NULL, PW_DIRECTION_OUTPUT);
+  TestStream* camera_viewer = connect_stream(
+      fixture, "test-camera-viewer", NULL, NULL, PW_DIRECTION_INPUT);
+  TestStream* screen_viewer = connect_stream(
+      fixture, "test-screen-viewer", NULL, NULL, PW_DIRECTION_INPUT);
+  guint32 camera_id = wait_for_node_id(fixture, camera);
+  guint32 screencast_id = wait_for_node_id(fixture, screencast);
+  guint32 camera_viewer_id = wait_for_node_id(fixture, camera_viewer);
+  guint32 screen_viewer_id = wait_for_node_id(fixture, screen_viewer);
+
+  // The registry reports globals in order, so once the screencast link is
+  // seen the camera link has been too.
+  pw_proxy* camera_link = link_nodes(fixture, camera_id, camera_viewer_id);
+  pw_proxy* screen_link = link_nodes(fixture, screencast_id, screen_viewer_id);
+  fixture->expected_node = screen_viewer_id;
+  g_assert_true(test_wait_until(is_capture_active, fixture, WAIT_TIMEOUT_MS));
+  g_assert_null(find_record(fixture->records, camera_viewer_id));
+
+  // Unlinking ends the capture.
+  destroy_link(fixture, screen_link);
+  g_assert_true(test_wait_until(is_capture_ended, fixture, WAIT_TIMEOUT_MS));
+  g_assert_cmpuint(find_record(fixture->records, screen_viewer_id)->n_changes,
+                   ==, 2);
+
+  destroy_link(fixture, camera_link);
+  destroy_stream(fixture, screen_viewer);
+  destroy_stream(fixture, camera_viewer);
+  destroy_stream(fixture, screencast);
+  destroy_stream(fixture, camera);
+}
+
+static void test_daemon_restart(Fixture* fixture, gconstpointer data) {
+  TestStream* screencast = connect_stream(
+      fixture, "xdpw_stream", "Video/Source", NULL, PW_DIRECTION_OUTPUT);
+  TestStream* viewer = connect_stream(fixture, "test-screen-viewer", NULL,
+                                      NULL, PW_DIRECTION_INPUT);
+  guint32 screencast_id = wait_for_node_id(fixture, screencast);
+  fixture->expected_node = wait_for_node_id(fixture, viewer);
+  link_nodes(fixture, screencast_id, fixture->expected_node);
+  g_assert_true(test_wait_until(is_capture_active, fixture, WAIT_TIMEOUT_MS));
+
+  // The daemon takes its streams down with it. Disconnecting the client
+  // also releases the link's proxy.
+  stop_daemon(fixture);
+  g_assert_true(test_wait_until(is_capture_ended, fixture, WAIT_TIMEOUT_MS));
+  destroy_stream(fixture, viewer);
+  destroy_stream(fixture, screencast);
+  disconnect_client(fixture);
+
+  // Once the monitor has reconnected, it reports new captures.
+  start_daemon(fixture);
+  connect_client(fixture);
+  screencast = connect_stream(fixture, "xdpw_stream", "Video/Source", NULL,
+                              PW_DIRECTION_OUTPUT);
+  viewer = connect_stream(fixture, "test-screen-viewer", NULL, NULL,
+                          PW_DIRECTION_INPUT);
+  screencast_id = wait_for_node_id(fixture, screencast);
+  fixture->expected_node = wait_for_node_id(fixture, viewer);
+  pw_proxy* link = link_nodes(fixture, screencast_id, fixture->expected_node);
+  g_assert_true(test_wait_until(is_capture_active, fixture, WAIT_TIMEOUT_MS));
+
+  destroy_link(fixture, link);
+  destroy_stream(fixture, viewer);
+  destroy_stream(fixture, screencast);
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  if (!test_require_program("pipewire")) return TEST_SKIP_EXIT_CODE;
+
+  g_test_add("/pipewire_monitor/screencast-not-camera", Fixture, NULL,
+             fixture_setup, test_screencast_not_camera, fixture_teardown);
+  g_test_add("/pipewire_monitor/daemon-restart", Fixture, NULL,
+             fixture_setup, test_daemon_restart, fixture_teardown);
+  return g_test_run();
+}
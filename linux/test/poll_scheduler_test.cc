@@ -0,0 +1,140 @@
+#include <glib.h>
+
+#include "poll_scheduler.h"
+#include "test/test_util.h"
+
+// Runs the scheduler on the main loop with intervals of a few milliseconds
+// and records the interval in effect at each poll.
+#define MIN_INTERVAL_MS 10
+#define MAX_INTERVAL_MS 80
+#define WAIT_TIMEOUT_MS 5000
+
+typedef struct {
+  PollScheduler* scheduler;
+  GArray* intervals;  // Interval that led to each poll, in order.
+  gboolean is_polling;
+
+  // What the poll does: how long it takes, after which poll it triggers
+  // the scheduler, and after which one it stops it.
+  guint cost_ms;
+  guint trigger_after;
+  guint n_polls;
+} Fixture;
+
+static gboolean on_poll(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  g_assert_false(fixture->is_polling);  // Never polls from within a poll.
+  fixture->is_polling = TRUE;
+
+  guint interval_ms = poll_scheduler_get_interval(fixture->scheduler);
+  g_array_append_val(fixture->intervals, interval_ms);
+  g_usleep(fixture->cost_ms * G_TIME_SPAN_MILLISECOND);
+  if (fixture->intervals->len == fixture->trigger_after) {
+    poll_scheduler_trigger(fixture->scheduler);
+  }
+  if (fixture->intervals->len == fixture->n_polls) {
+    poll_scheduler_stop(fixture->scheduler);
+  }
+
+  fixture->is_polling = FALSE;
+  return FALSE;
+}
+
+static gboolean has_polled_all(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  return fixture->intervals->len >= fixture->n_polls;
+}
+
+static void start_scheduler(Fixture* fixture,
+                            guint min_interval_ms,
+                            guint max_interval_ms,
+                            gdouble cpu_budget) {
+  PollSchedulerConfig config = {min_interval_ms, max_interval_ms, cpu_budget};
+  fixture->scheduler = poll_scheduler_new(&config, on_poll, fixture);
+  poll_scheduler_start(fixture->scheduler);
+}
+
+static void assert_intervals(Fixture* fixture,
+                             const guint* expected,
+                             guint n_expected) {
+  g_assert_cmpuint(fixture->intervals->len, ==, n_expected);
+  for (guint i = 0; i < n_expected; i++) {
+    g_assert_cmpuint(g_array_index(fixture->intervals, guint, i), ==,
+                     expected[i]);
+  }
+}
+
+static void fixture_setup(Fixture* fixture, gconstpointer data) {
+  fixture->intervals = g_array_new(FALSE, FALSE, sizeof(guint));
+}
+
+static void fixture_teardown(Fixture* fixture, gconstpointer data) {
+  poll_scheduler_free(fixture->scheduler);
+  g_array_unref(fixture->intervals);
+}
+
+static void test_backoff(Fixture* fixture, gconstpointer data) {
+  fixture->n_polls = 6;
+  start_scheduler(fixture, MIN_INTERVAL_MS, MAX_INTERVAL_MS, 1);
+  g_assert_true(test_wait_until(has_polled_all, fixture, WAIT_TIMEOUT_MS));
+
+  // Starting polls at once; idle polls then double up to the maximum.
+  const guint expected[] = {10, 10, 20, 40, 80, 80};
+  assert_intervals(fixture, expected, G_N_ELEMENTS(expected));
+}
+
+static void test_trigger_while_polling(Fixture* fixture, gconstpointer data) {
+  fixture->trigger_after = 3;
+  fixture->n_polls = 6;
+  start_scheduler(fixture, MIN_INTERVAL_MS, MAX_INTERVAL_MS, 1);
+  g_assert_true(test_wait_until(has_polled_all, fixture, WAIT_TIMEOUT_MS));
+
+  // The trigger during the third poll does not poll again right away but
+  // restarts the back-off once that poll is done.
+  const guint expected[] = {10, 10, 20, 10, 20, 40};
+  assert_intervals(fixture, expected, G_N_ELEMENTS(expected));
+}
+
+static void test_attentive(Fixture* fixture, gconstpointer data) {
+  fixture->n_polls = 4;
+  start_scheduler(fixture, MIN_INTERVAL_MS, MAX_INTERVAL_MS, 1);
+  poll_scheduler_set_attentive(fixture->scheduler, TRUE);
+
+  // Becoming attentive polls at once, and then at the minimum only.
+  g_assert_cmpuint(fixture->intervals->len, ==, 2);
+  g_assert_true(test_wait_until(has_polled_all, fixture, WAIT_TIMEOUT_MS));
+  const guint expected[] = {10, 10, 10, 10};
+  assert_intervals(fixture, expected, G_N_ELEMENTS(expected));
+}
+
+static void test_cpu_budget(Fixture* fixture, gconstpointer data) {
+  // Polls taking 20 ms within 10% of a core run at most every 200 ms,
+  // beyond the maximum interval and even while attentive.
+  fixture->cost_ms = 20;
+  fixture->n_polls = 2;
+  start_scheduler(fixture, MIN_INTERVAL_MS, MAX_INTERVAL_MS, 0.1);
+  g_assert_cmpuint(poll_scheduler_get_interval(fixture->scheduler), >=, 200);
+  poll_scheduler_set_attentive(fixture->scheduler, TRUE);
+  g_assert_cmpuint(fixture->intervals->len, ==, 2);
+  g_assert_cmpuint(poll_scheduler_get_interval(fixture->scheduler), >=, 200);
+
+  // A cheaper poll lowers the floor again.
+  fixture->cost_ms = 0;
+  poll_scheduler_stop(fixture->scheduler);
+  poll_scheduler_start(fixture->scheduler);
+  g_assert_cmpuint(poll_scheduler_get_interval(fixture->scheduler), ==,
+                   MIN_INTERVAL_MS);
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  g_test_add("/poll_scheduler/backoff", Fixture, NULL, fixture_setup,
+             test_backoff, fixture_teardown);
+  g_test_add("/poll_scheduler/trigger-while-polling", Fixture, NULL,
+             fixture_setup, test_trigger_while_polling, fixture_teardown);
+  g_test_add("/poll_scheduler/attentive", Fixture, NULL, fixture_setup,
+             test_attentive, fixture_teardown);
+  g_test_add("/poll_scheduler/cpu-budget", Fixture, NULL, fixture_setup,
+             test_cpu_budget, fixture_teardown);
+  return g_test_run();
+}
@@ -0,0 +1,180 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "proc_scanner.h"
+
+// Run with "-m perf" for the benchmark over a /proc-sized tree.
+#define SMALL_TREE_SIZE 500
+#define LARGE_TREE_SIZE 50000
+
+typedef struct {
+  gchar* root;
+  guint n_processes;
+} ProcTree;
+
+// Writes <root>/<pid>/stat for a process named "proc-<pid>".
+static void add_process(ProcTree* tree, guint pid, guint64 start_time) {
+  g_autofree gchar* dir = g_strdup_printf("%s/%u", tree->root, pid);
+  g_autofree gchar* stat_path = g_build_filename(dir, "stat", NULL);
+  g_autofree gchar* stat = g_strdup_printf(
+      "%u (proc-%u) S 1 %u %u 0 -1 4194560 100 0 0 0 1 1 0 0 20 0 1 0 "
+      "%" G_GUINT64_FORMAT " 1000 100 18446744073709551615",
+      pid, pid, pid, pid, start_time);
+  g_assert_cmpint(g_mkdir(dir, 0755), ==, 0);
+  g_assert_true(g_file_set_contents(stat_path, stat, -1, NULL));
+}
+
+// Creates |n| processes started at 1000 + <pid>.
+static void proc_tree_init(ProcTree* tree, guint n) {
+  tree->root = g_dir_make_tmp("proc_scanner_test-XXXXXX", NULL);
+  g_assert_nonnull(tree->root);
+  tree->n_processes = n;
+  for (guint pid = 1; pid <= n; pid++) add_process(tree, pid, 1000 + pid);
+}
+
+static void remove_process(ProcTree* tree, guint pid) {
+  g_autofree gchar* dir = g_strdup_printf("%s/%u", tree->root, pid);
+  g_autofree gchar* stat_path = g_build_filename(dir, "stat", NULL);
+  g_unlink(stat_path);
+  g_rmdir(dir);
+}
+
+static void proc_tree_clear(ProcTree* tree) {
+  for (guint pid = 1; pid <= tree->n_processes; pid++) {
+    remove_process(tree, pid);
+  }
+  g_rmdir(tree->root);
+  g_free(tree->root);
+}
+
+typedef struct {
+  guint n_appeared;
+  guint n_gone;
+  gboolean has_wrong_name;
+  guint64 last_start_time;
+} ScanCounts;
+
+static void on_process(gint pid,
+                       guint64 start_time,
+                       const gchar* comm,
+                       gpointer user_data) {
+  ScanCounts* counts = (ScanCounts*)user_data;
+  if (comm == NULL) {
+    counts->n_gone++;
+    return;
+  }
+  counts->n_appeared++;
+  counts->last_start_time = start_time;
+  g_autofree gchar* expected = g_strdup_printf("proc-%d", pid);
+  if (g_strcmp0(comm, expected) != 0 || start_time != 1000u + (guint)pid) {
+    counts->has_wrong_name = TRUE;
+  }
+}
+
+static void test_cold_and_incremental_scan() {
+  ProcTree tree;
+  proc_tree_init(&tree, SMALL_TREE_SIZE);
+  ScanCounts counts = {0, 0, FALSE, 0};
+  ProcScanner* scanner = proc_scanner_new(tree.root, on_process, &counts);
+
+  g_assert_true(proc_scanner_scan(scanner, FALSE));
+  g_assert_cmpuint(counts.n_appeared, ==, SMALL_TREE_SIZE);
+  g_assert_false(counts.has_wrong_name);
+
+  // New entries are read once more; after that a sweep reads nothing.
+  proc_scanner_scan(scanner, FALSE);
+  counts.n_appeared = 0;
+  proc_scanner_scan(scanner, FALSE);
+  g_assert_cmpuint(counts.n_appeared, ==, 0);
+
+  remove_process(&tree, 7);
+  remove_process(&tree, 300);
+  proc_scanner_scan(scanner, FALSE);
+  g_assert_cmpuint(counts.n_gone, ==, 2);
+  g_assert_false(proc_scanner_is_same_process(scanner, 7, 1007));
+  g_assert_true(proc_scanner_is_same_process(scanner, 8, 1008));
+
+  proc_scanner_free(scanner);
+  proc_tree_clear(&tree);
+}
+
+static void test_cgroup_scan() {
+  ProcTree tree;
+  proc_tree_init(&tree, SMALL_TREE_SIZE);
+  g_autofree gchar* cgroup_dir =
+      g_dir_make_tmp("proc_scanner_test-cgroup-XXXXXX", NULL);
+  g_autofree gchar* procs_path =
+      g_build_filename(cgroup_dir, "cgroup.procs", NULL);
+  g_assert_true(g_file_set_contents(procs_path, "5\n6\n", -1, NULL));
+
+  ScanCounts counts = {0, 0, FALSE, 0};
+  ProcScanner* scanner = proc_scanner_new(tree.root, on_process, &counts);
+  g_assert_true(proc_scanner_set_scope(scanner, cgroup_dir));
+  proc_scanner_scan(scanner, FALSE);
+  g_assert_cmpuint(counts.n_appeared, ==, 2);
+  proc_scanner_scan(scanner, FALSE);
+  counts.n_appeared = 0;
+  proc_scanner_scan(scanner, FALSE);
+  g_assert_cmpuint(counts.n_appeared, ==, 0);
+
+  // PID 5 is reused by a new process; the old /proc/5 is moved aside
+  // rather than removed so the new one cannot get its inode.
+  g_autofree gchar* old_dir = g_strdup_printf("%s/5", tree.root);
+  g_autofree gchar* moved_dir = g_strdup_printf("%s/5.old", tree.root);
+  g_assert_cmpint(g_rename(old_dir, moved_dir), ==, 0);
+  add_process(&tree, 5, 9000);
+  proc_scanner_scan(scanner, FALSE);
+  g_assert_cmpuint(counts.n_appeared, ==, 1);
+  g_assert_cmpuint(counts.last_start_time, ==, 9000);
+  g_assert_cmpuint(counts.n_gone, ==, 0);
+
+  proc_scanner_free(scanner);
+  g_autofree gchar* moved_stat = g_build_filename(moved_dir, "stat", NULL);
+  g_unlink(moved_stat);
+  g_rmdir(moved_dir);
+  g_unlink(procs_path);
+  g_rmdir(cgroup_dir);
+  proc_tree_clear(&tree);
+}
+
+static void test_benchmark() {
+  if (!g_test_perf()) {
+    g_test_skip("benchmark; run with -m perf");
+    return;
+  }
+  ProcTree tree;
+  proc_tree_init(&tree, LARGE_TREE_SIZE);
+  ScanCounts counts = {0, 0, FALSE, 0};
+  ProcScanner* scanner = proc_scanner_new(tree.root, on_process, &counts);
+
+  g_test_timer_start();
+  proc_scanner_scan(scanner, FALSE);
+  gdouble cold = g_test_timer_elapsed();
+  g_assert_cmpuint(counts.n_appeared, ==, LARGE_TREE_SIZE);
+
+  g_test_timer_start();
+  proc_scanner_scan(scanner, TRUE);
+  gdouble full = g_test_timer_elapsed();
+
+  proc_scanner_scan(scanner, FALSE);  // Settles the new entries.
+  g_test_timer_start();
+  proc_scanner_scan(scanner, FALSE);
+  gdouble warm = g_test_timer_elapsed();
+
+  g_test_minimized_result(cold, "cold scan of %d processes: %.1f ms",
+                          LARGE_TREE_SIZE, cold * 1000);
+  g_test_minimized_result(full, "full rescan: %.1f ms", full * 1000);
+  g_test_minimized_result(warm, "incremental scan: %.1f ms", warm * 1000);
+
+  proc_scanner_free(scanner);
+  proc_tree_clear(&tree);
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  g_test_add_func("/proc_scanner/cold-and-incremental-scan",
+                  test_cold_and_incremental_scan);
+  g_test_add_func("/proc_scanner/cgroup-scan", test_cgroup_scan);
+  g_test_add_func("/proc_scanner/benchmark", test_benchmark);
+  return g_test_run();
+}
@@ -0,0 +1,169 @@
+#include <glib.h>
+#include <string.h>
+
+#include "recorder_catalog.h"
+#include "recorder_catalog_index.h"
+
+// Run with "-m perf" for the benchmark, which compares lookups in the
+// built-in catalog with a generated one of GENERATED_SIZE recorder,
+// streamer and remote-desktop names.
+#define GENERATED_SIZE 400
+#define NAME_MAX_LEN 32
+#define N_COMMS 1000
+#define N_ROUNDS 2000
+
+static const gchar* const kNamePrefixes[] = {
+    "obs", "screen", "rec", "cast", "stream", "remote", "vnc",
+    "rdp", "desk", "grab", "capture", "gpu", "wl", "x11",
+    "kde", "gnome", "share", "live", "mirror", "view",
+};
+
+static const gchar* const kNameSuffixes[] = {
+    "recorder", "cap", "studio", "share", "desktop", "viewer", "server",
+    "cast", "helper", "ng", "rec", "stream", "link", "vid",
+    "shot", "mirror", "record", "grabber", "encoder", "-broadcaster",
+};
+
+static gchar generated_names[GENERATED_SIZE][NAME_MAX_LEN];
+static KnownRecorder generated[GENERATED_SIZE];
+static CatalogIndex<GENERATED_SIZE> generated_index;
+
+static void generate_catalog() {
+  guint n = 0;
+  for (const gchar* prefix : kNamePrefixes) {
+    for (const gchar* suffix : kNameSuffixes) {
+      g_snprintf(generated_names[n], NAME_MAX_LEN, "%s-%s", prefix, suffix);
+      generated[n] = {generated_names[n], FALSE, FALSE};
+      n++;
+    }
+  }
+  g_assert_cmpuint(n, ==, GENERATED_SIZE);
+  generated_index = catalog_index_build(generated);
+}
+
+// The comm the kernel reports for |name|.
+static gchar* comm_of(const gchar* name) {
+  return g_strndup(name, CATALOG_SIGNATURE_SIZE - 1);
+}
+
+static void test_exact_match() {
+  const KnownRecorder* ffmpeg = recorder_catalog_match_comm("ffmpeg");
+  g_assert_nonnull(ffmpeg);
+  g_assert_cmpstr(ffmpeg->name, ==, "ffmpeg");
+  g_assert_true(ffmpeg->needs_capture_input);
+  g_assert_cmpstr(recorder_catalog_match_comm("obs")->name, ==, "obs");
+
+  // Names that share a prefix are told apart.
+  g_assert_cmpstr(recorder_catalog_match_comm("vokoscreen")->name, ==,
+                  "vokoscreen");
+  g_assert_cmpstr(recorder_catalog_match_comm("vokoscreenNG")->name, ==,
+                  "vokoscreenNG");
+
+  // Short names match only in full.
+  g_assert_null(recorder_catalog_match_comm(""));
+  g_assert_null(recorder_catalog_match_comm("ob"));
+  g_assert_null(recorder_catalog_match_comm("obs-studio"));
+  g_assert_null(recorder_catalog_match_comm("ffmpeg2"));
+  g_assert_null(recorder_catalog_match_comm("bash"));
+}
+
+static void test_truncated_match() {
+  // The kernel keeps the first 15 characters of a longer name.
+  const KnownRecorder* recorder =
+      recorder_catalog_match_comm("simplescreenrec");
+  g_assert_nonnull(recorder);
+  g_assert_cmpstr(recorder->name, ==, "simplescreenrecorder");
+  g_assert_cmpstr(recorder_catalog_match_comm("gpu-screen-reco")->name, ==,
+                  "gpu-screen-recorder");
+
+  // Shorter prefixes are other programs, and no comm is longer.
+  g_assert_null(recorder_catalog_match_comm("simplescreenre"));
+  g_assert_null(recorder_catalog_match_comm("simplescreen"));
+  g_assert_null(recorder_catalog_match_comm("simplescreenrecorder"));
+}
+
+static void test_generated_catalog() {
+  for (guint i = 0; i < GENERATED_SIZE; i++) {
+    g_autofree gchar* comm = comm_of(generated[i].name);
+    const KnownRecorder* recorder =
+        catalog_index_match(generated_index, generated, comm);
+    g_assert_nonnull(recorder);
+    // Names sharing their first 15 characters match the first of them.
+    g_assert_true(g_str_has_prefix(recorder->name, comm));
+  }
+  g_assert_null(catalog_index_match(generated_index, generated, "obs"));
+  g_assert_null(
+      catalog_index_match(generated_index, generated, "live--broadcaster"));
+}
+
+// What the catalog replaced: one pass over every name per comm.
+static const KnownRecorder* match_linear(const gchar* comm) {
+  for (const KnownRecorder& recorder : generated) {
+    if (g_str_has_prefix(recorder.name, comm) &&
+        (strlen(comm) == CATALOG_SIGNATURE_SIZE - 1 ||
+         strlen(recorder.name) == strlen(comm))) {
+      return &recorder;
+    }
+  }
+  return NULL;
+}
+
+static void test_benchmark() {
+  if (!g_test_perf()) {
+    g_test_skip("benchmark; run with -m perf");
+    return;
+  }
+
+  // Mostly other processes, as on a desktop, with one recorder in 50.
+  gchar* comms[N_COMMS];
+  for (guint i = 0; i < N_COMMS; i++) {
+    comms[i] = i % 50 == 0
+                   ? comm_of(generated[i % GENERATED_SIZE].name)
+                   : g_strdup_printf("proc-%u", i);
+  }
+
+  guint n_found = 0;
+  g_test_timer_start();
+  for (guint round = 0; round < N_ROUNDS; round++) {
+    for (gchar* comm : comms) {
+      n_found += recorder_catalog_match_comm(comm) != NULL;
+    }
+  }
+  gdouble builtin = g_test_timer_elapsed();
+
+  g_test_timer_start();
+  for (guint round = 0; round < N_ROUNDS; round++) {
+    for (gchar* comm : comms) {
+      n_found +=
+          catalog_index_match(generated_index, generated, comm) != NULL;
+    }
+  }
+  gdouble indexed = g_test_timer_elapsed();
+
+  g_test_timer_start();
+  for (guint round = 0; round < N_ROUNDS; round++) {
+    for (gchar* comm : comms) n_found += match_linear(comm) != NULL;
+  }
+  gdouble linear = g_test_timer_elapsed();
+  g_assert_cmpuint(n_found, ==, 2 * N_ROUNDS * (N_COMMS / 50));
+
+  gdouble n_lookups = (gdouble)N_ROUNDS * N_COMMS;
+  g_test_minimized_result(builtin, "built-in catalog: %.1f ns",
+                          builtin * 1e9 / n_lookups);
+  g_test_minimized_result(indexed, "generated catalog (%d names): %.1f ns",
+                          GENERATED_SIZE, indexed * 1e9 / n_lookups);
+  g_test_minimized_result(linear, "linear prefix scan (%d names): %.1f ns",
+                          GENERATED_SIZE, linear * 1e9 / n_lookups);
+  for (gchar* comm : comms) g_free(comm);
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  generate_catalog();
+  g_test_add_func("/recorder_catalog/exact-match", test_exact_match);
+  g_test_add_func("/recorder_catalog/truncated-match", test_truncated_match);
+  g_test_add_func("/recorder_catalog/generated-catalog",
+                  test_generated_catalog);
+  g_test_add_func("/recorder_catalog/benchmark", test_benchmark);
+  return g_test_run();
+}
@@ -0,0 +1,377 @@
+#include <gio/gio.h>
+#include <glib.h>
+
+#include "screencast_monitor.h"
+#include "test/test_util.h"
+
+// Runs the monitor against a private dbus-daemon with a stub
+// xdg-desktop-portal that answers ScreenCast.Start with a Request.Response
+// and accepts Session.Close, like the real portal once the user has chosen.
+// Skipped when dbus-daemon is not installed.
+#define PORTAL_NAME "org.freedesktop.portal.Desktop"
+#define PORTAL_PATH "/org/freedesktop/portal/desktop"
+#define SCREENCAST_INTERFACE "org.freedesktop.portal.ScreenCast"
+#define REQUEST_INTERFACE "org.freedesktop.portal.Request"
+#define SESSION_INTERFACE "org.freedesktop.portal.Session"
+#define REQUEST_PATH_PREFIX "/org/freedesktop/portal/desktop/request/"
+#define SESSION_PATH_PREFIX "/org/freedesktop/portal/desktop/session/test/"
+#define WAIT_TIMEOUT_MS 5000
+#define PROBE_INTERVAL_MS 100
+
+// The portal's response codes.
+#define RESPONSE_SUCCESS 0
+#define RESPONSE_CANCELLED 1
+
+static const gchar kPortalXml[] =
+    "<node>"
+    "  <interface name='" SCREENCAST_INTERFACE "'>"
+    "    <method name='Start'>"
+    "      <arg type='o' name='session_handle' direction='in'/>"
+    "      <arg type='s' name='parent_window' direction='in'/>"
+    "      <arg type='a{sv}' name='options' direction='in'/>"
+    "      <arg type='o' name='handle' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "  <interface name='" SESSION_INTERFACE "'>"
+    "    <method name='Close'/>"
+    "  </interface>"
+    "</node>";
+
+typedef struct {
+  GTestDBus* test_bus;
+  GDBusNodeInfo* portal_info;
+  GDBusConnection* portal;
+  GDBusConnection* client;
+  gboolean is_call_done;
+  GHashTable* registrations;  // Session path → registration id.
+  guint response;  // What the stub portal answers the next Start with.
+  guint n_requests;
+
+  ScreenCastMonitor* monitor;
+  GHashTable* sessions;  // Active session path → app name.
+  guint n_ended;
+  const gchar* expected_session;  // What the conditions below look at.
+  GPtrArray* probes;  // Sessions started until the monitor saw one.
+} Fixture;
+
+static void on_screencast_changed(const gchar* session,
+                                  const gchar* app_name,
+                                  gboolean is_active,
+                                  gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  if (is_active) {
+    g_hash_table_replace(fixture->sessions, g_strdup(session),
+                         g_strdup(app_name));
+  } else {
+    g_hash_table_remove(fixture->sessions, session);
+    fixture->n_ended++;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Stub portal
+// ---------------------------------------------------------------------------
+
+static void on_portal_method_call(GDBusConnection* connection,
+                                  const gchar* sender,
+                                  const gchar* object_path,
+                                  const gchar* interface_name,
+                                  const gchar* method_name,
+                                  GVariant* parameters,
+                                  GDBusMethodInvocation* invocation,
+                                  gpointer user_data);
+
+static const GDBusInterfaceVTable kPortalVTable = {
+    on_portal_method_call,
+    NULL,
+    NULL,
+};
+
+static void handle_start(Fixture* fixture,
+                         GDBusMethodInvocation* invocation,
+                         GVariant* parameters) {
+  const gchar* sender = g_dbus_method_invocation_get_sender(invocation);
+  const gchar* session = NULL;
+  g_autoptr(GVariant) options = NULL;
+  g_variant_get(parameters, "(&o&s@a{sv})", &session, NULL, &options);
+
+  guint registration_id = g_dbus_connection_register_object(
+      fixture->portal, session,
+      g_dbus_node_info_lookup_interface(fixture->portal_info,
+                                        SESSION_INTERFACE),
+      &kPortalVTable, fixture, NULL, NULL);
+  g_hash_table_replace(fixture->registrations, g_strdup(session),
+                       GUINT_TO_POINTER(registration_id));
+
+  // Request handles follow the portal's documented scheme.
+  const gchar* token = NULL;
+  g_autofree gchar* generated_token = NULL;
+  if (!g_variant_lookup(options, "handle_token", "&s", &token)) {
+    generated_token = g_strdup_printf("portal%u", ++fixture->n_requests);
+    token = generated_token;
+  }
+  g_autofree gchar* escaped = g_strdup(sender + 1);
+  g_strdelimit(escaped, ".", '_');
+  g_autofree gchar* handle =
+      g_strconcat(REQUEST_PATH_PREFIX, escaped, "/", token, NULL);
+  g_dbus_method_invocation_return_value(invocation,
+                                        g_variant_new("(o)", handle));
+
+  GVariant* response =
+      fixture->response == RESPONSE_SUCCESS
+          ? g_variant_new_parsed(
+                "(uint32 0, {'streams': <[(uint32 42, @a{sv} {})]>})")
+          : g_variant_new_parsed("(uint32 %u, @a{sv} {})",
+                                 (guint32)fixture->response);
+  g_dbus_connection_emit_signal(fixture->portal, sender, handle,
+                                REQUEST_INTERFACE, "Response", response,
+                                NULL);
+}
+
+static void on_portal_method_call(GDBusConnection* connection,
+                                  const gchar* sender,
+                                  const gchar* object_path,
+                                  const gchar* interface_name,
+                                  const gchar* method_name,
+                                  GVariant* parameters,
+                                  GDBusMethodInvocation* invocation,
+                                  gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  if (g_strcmp0(interface_name, SCREENCAST_INTERFACE) == 0) {
+    handle_start(fixture, invocation, parameters);
+    return;
+  }
+  g_dbus_method_invocation_return_value(invocation, NULL);
+  guint registration_id = GPOINTER_TO_UINT(
+      g_hash_table_lookup(fixture->registrations, object_path));
+  if (registration_id != 0) {
+    g_dbus_connection_unregister_object(connection, registration_id);
+    g_hash_table_remove(fixture->registrations, object_path);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Client
+// ---------------------------------------------------------------------------
+
+static GDBusConnection* connect_to_test_bus(Fixture* fixture) {
+  g_autoptr(GError) error = NULL;
+  GDBusConnection* connection = g_dbus_connection_new_for_address_sync(
+      g_test_dbus_get_bus_address(fixture->test_bus),
+      (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+      NULL, NULL, &error);
+  g_assert_no_error(error);
+  return connection;
+}
+
+static void on_call_done(GObject* source,
+                         GAsyncResult* result,
+                         gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GVariant) reply = g_dbus_connection_call_finish(
+      G_DBUS_CONNECTION(source), result, &error);
+  g_assert_no_error(error);
+  *(gboolean*)user_data = TRUE;
+}
+
+static gboolean is_call_done(gpointer user_data) {
+  return ((Fixture*)user_data)->is_call_done;
+}
+
+// The stub portal shares this thread's main loop, so calls to it must not
+// block.
+static void call_portal(Fixture* fixture,
+                        const gchar* path,
+                        const gchar* interface_name,
+                        const gchar* method,
+                        GVariant* parameters) {
+  fixture->is_call_done = FALSE;
+  g_dbus_connection_call(fixture->client, PORTAL_NAME, path, interface_name,
+                         method, parameters, NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+                         NULL, on_call_done, &fixture->is_call_done);
+  g_assert_true(test_wait_until(is_call_done, fixture, WAIT_TIMEOUT_MS));
+}
+
+static gchar* start_screencast(Fixture* fixture,
+                               const gchar* name,
+                               const gchar* token) {
+  gchar* session = g_strconcat(SESSION_PATH_PREFIX, name, NULL);
+  GVariantBuilder options;
+  g_variant_builder_init(&options, G_VARIANT_TYPE_VARDICT);
+  if (token != NULL) {
+    g_variant_builder_add(&options, "{sv}", "handle_token",
+                          g_variant_new_string(token));
+  }
+  call_portal(fixture, PORTAL_PATH, SCREENCAST_INTERFACE, "Start",
+              g_variant_new("(osa{sv})", session, "", &options));
+  return session;
+}
+
+static void close_session(Fixture* fixture, const gchar* session) {
+  call_portal(fixture, session, SESSION_INTERFACE, "Close", NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Fixture
+// ---------------------------------------------------------------------------
+
+static gboolean is_expected_active(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  return g_hash_table_contains(fixture->sessions, fixture->expected_session);
+}
+
+static gboolean is_expected_ended(gpointer user_data) {
+  return !is_expected_active(user_data);
+}
+
+static gboolean is_app_named(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  const gchar* app_name = (const gchar*)g_hash_table_lookup(
+      fixture->sessions, fixture->expected_session);
+  return app_name != NULL && app_name[0] != '\0';
+}
+
+static gboolean has_sessions(gpointer user_data) {
+  return g_hash_table_size(((Fixture*)user_data)->sessions) > 0;
+}
+
+static gboolean has_no_sessions(gpointer user_data) {
+  return !has_sessions(user_data);
+}
+
+static void start_probe(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  g_autofree gchar* name = g_strdup_printf("probe%u", fixture->probes->len);
+  g_ptr_array_add(fixture->probes, start_screencast(fixture, name, name));
+}
+
+static void fixture_setup(Fixture* fixture, gconstpointer data) {
+  fixture->test_bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+  g_test_dbus_up(fixture->test_bus);
+
+  g_autoptr(GError) error = NULL;
+  fixture->portal_info = g_dbus_node_info_new_for_xml(kPortalXml, &error);
+  g_assert_no_error(error);
+  fixture->portal = connect_to_test_bus(fixture);
+  fixture->registrations =
+      g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  g_dbus_connection_register_object(
+      fixture->portal, PORTAL_PATH,
+      g_dbus_node_info_lookup_interface(fixture->portal_info,
+                                        SCREENCAST_INTERFACE),
+      &kPortalVTable, fixture, NULL, &error);
+  g_assert_no_error(error);
+  g_autoptr(GVariant) reply = g_dbus_connection_call_sync(
+      fixture->portal, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+      "org.freedesktop.DBus", "RequestName",
+      g_variant_new("(su)", PORTAL_NAME, 0), NULL, G_DBUS_CALL_FLAGS_NONE,
+      -1, NULL, &error);
+  g_assert_no_error(error);
+
+  fixture->client = connect_to_test_bus(fixture);
+  fixture->response = RESPONSE_SUCCESS;
+  fixture->sessions =
+      g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+  fixture->monitor = screencast_monitor_new(
+      g_test_dbus_get_bus_address(fixture->test_bus), on_screencast_changed,
+      fixture);
+  screencast_monitor_start(fixture->monitor);
+
+  // Returns once the monitor reports screencasts, with none left open.
+  fixture->probes = g_ptr_array_new_with_free_func(g_free);
+  g_assert_true(test_probe_until(start_probe, has_sessions, fixture,
+                                 PROBE_INTERVAL_MS, WAIT_TIMEOUT_MS));
+  for (guint i = 0; i < fixture->probes->len; i++) {
+    close_session(fixture,
+                  (const gchar*)g_ptr_array_index(fixture->probes, i));
+  }
+  g_assert_true(test_wait_until(has_no_sessions, fixture, WAIT_TIMEOUT_MS));
+  fixture->n_ended = 0;
+}
+
+static void fixture_teardown(Fixture* fixture, gconstpointer data) {
+  screencast_monitor_free(fixture->monitor);
+  g_hash_table_unref(fixture->sessions);
+  g_ptr_array_unref(fixture->probes);
+  if (fixture->client != NULL) {
+    g_dbus_connection_close_sync(fixture->client, NULL, NULL);
+    g_object_unref(fixture->client);
+  }
+  g_dbus_connection_close_sync(fixture->portal, NULL, NULL);
+  g_object_unref(fixture->portal);
+  g_hash_table_unref(fixture->registrations);
+  g_dbus_node_info_unref(fixture->portal_info);
+  g_test_dbus_down(fixture->test_bus);
+  g_object_unref(fixture->test_bus);
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+static void test_start_and_close(Fixture* fixture, gconstpointer data) {
+  g_autofree gchar* session = start_screencast(fixture, "cast", "token1");
+  fixture->expected_session = session;
+  g_assert_true(
+      test_wait_until(is_expected_active, fixture, WAIT_TIMEOUT_MS));
+  g_assert_cmpuint(screencast_monitor_get_count(fixture->monitor), ==, 1);
+
+  // The client is this process, so its name comes from our own comm.
+  g_assert_true(test_wait_until(is_app_named, fixture, WAIT_TIMEOUT_MS));
+  g_autofree gchar* comm = NULL;
+  g_assert_true(g_file_get_contents("/proc/self/comm", &comm, NULL, NULL));
+  g_assert_cmpstr(
+      (const gchar*)g_hash_table_lookup(fixture->sessions, session), ==,
+      g_strstrip(comm));
+
+  close_session(fixture, session);
+  g_assert_true(test_wait_until(is_expected_ended, fixture, WAIT_TIMEOUT_MS));
+  g_assert_cmpuint(fixture->n_ended, ==, 1);
+  g_assert_cmpuint(screencast_monitor_get_count(fixture->monitor), ==, 0);
+}
+
+static void test_cancelled_and_untokened(Fixture* fixture,
+                                         gconstpointer data) {
+  // The user dismissed the dialog: no screencast.
+  fixture->response = RESPONSE_CANCELLED;
+  g_autofree gchar* cancelled =
+      start_screencast(fixture, "cancelled", "token2");
+
+  // Without a handle_token the Response is matched by its destination.
+  // Messages reach the monitor in order, so once this one is reported the
+  // cancelled one has been handled too.
+  fixture->response = RESPONSE_SUCCESS;
+  g_autofree gchar* session = start_screencast(fixture, "untokened", NULL);
+  fixture->expected_session = session;
+  g_assert_true(
+      test_wait_until(is_expected_active, fixture, WAIT_TIMEOUT_MS));
+  g_assert_false(g_hash_table_contains(fixture->sessions, cancelled));
+  g_assert_cmpuint(screencast_monitor_get_count(fixture->monitor), ==, 1);
+}
+
+static void test_client_vanishes(Fixture* fixture, gconstpointer data) {
+  g_autofree gchar* session = start_screencast(fixture, "orphan", "token3");
+  fixture->expected_session = session;
+  g_assert_true(
+      test_wait_until(is_expected_active, fixture, WAIT_TIMEOUT_MS));
+
+  // Leaving the bus without Close ends the session too.
+  g_dbus_connection_close_sync(fixture->client, NULL, NULL);
+  g_clear_object(&fixture->client);
+  g_assert_true(test_wait_until(is_expected_ended, fixture, WAIT_TIMEOUT_MS));
+  g_assert_cmpuint(screencast_monitor_get_count(fixture->monitor), ==, 0);
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  if (!test_require_program("dbus-daemon")) return TEST_SKIP_EXIT_CODE;
+
+  g_test_add("/screencast_monitor/start-and-close", Fixture, NULL,
+             fixture_setup, test_start_and_close, fixture_teardown);
+  g_test_add("/screencast_monitor/cancelled-and-untokened", Fixture, NULL,
+             fixture_setup, test_cancelled_and_untokened, fixture_teardown);
+  g_test_add("/screencast_monitor/client-vanishes", Fixture, NULL,
+             fixture_setup, test_client_vanishes, fixture_teardown);
+  return g_test_run();
+}
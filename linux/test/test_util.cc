@@ -0,0 +1,41 @@
+#include "test/test_util.h"
+
+#include <stdio.h>
+
+gboolean test_require_program(const gchar* program) {
+  g_autofree gchar* path = g_find_program_in_path(program);
+  if (path != NULL) return TRUE;
+  printf("1..0 # SKIP %s is not installed\n", program);
+  return FALSE;
+}
+
+static gboolean on_wait_timeout(gpointer user_data) {
+  *(gboolean*)user_data = TRUE;
+  return G_SOURCE_REMOVE;
+}
+
+gboolean test_wait_until(TestCondition condition,
+                         gpointer user_data,
+                         guint timeout_ms) {
+  gboolean is_timed_out = FALSE;
+  guint timeout_id = g_timeout_add(timeout_ms, on_wait_timeout, &is_timed_out);
+  while (!condition(user_data) && !is_timed_out) {
+    g_main_context_iteration(NULL, TRUE);
+  }
+  if (!is_timed_out) g_source_remove(timeout_id);
+  return condition(user_data);
+}
+
+gboolean test_probe_until(TestProbe probe,
+                          TestCondition condition,
+                          gpointer user_data,
+                          guint interval_ms,
+                          guint timeout_ms) {
+  gint64 deadline =
+      g_get_monotonic_time() + timeout_ms * G_TIME_SPAN_MILLISECOND;
+  while (g_get_monotonic_time() < deadline) {
+    probe(user_data);
+    if (test_wait_until(condition, user_data, interval_ms)) return TRUE;
+  }
+  return FALSE;
+}
@@ -0,0 +1,36 @@
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Exit status of a test program whose prerequisites are missing; ctest
+// reports it as skipped (see add_plugin_test).
+#define TEST_SKIP_EXIT_CODE 77
+
+typedef gboolean (*TestCondition)(gpointer user_data);
+typedef void (*TestProbe)(gpointer user_data);
+
+// Returns FALSE, after reporting every test as skipped, if |program| is not
+// installed. Call it from main() after g_test_init().
+gboolean test_require_program(const gchar* program);
+
+// Dispatches the default main context until |condition| holds or
+// |timeout_ms| passes, and returns whether it holds.
+gboolean test_wait_until(TestCondition condition,
+                         gpointer user_data,
+                         guint timeout_ms);
+
+// For subscriptions that report no completion: runs |probe| — which should
+// cause an event the subscriber reports — every |interval_ms| until
+// |condition| holds or |timeout_ms| passes, and returns whether it holds.
+gboolean test_probe_until(TestProbe probe,
+                          TestCondition condition,
+                          gpointer user_data,
+                          guint interval_ms,
+                          guint timeout_ms);
+
+G_END_DECLS
+
+#endif  // TEST_UTIL_H_
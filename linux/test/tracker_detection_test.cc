@@ -0,0 +1,162 @@
+#include <gio/gio.h>
+#include <glib.h>
+
+#include <libtracker-sparql/tracker-sparql.h>
+
+#include "test/test_util.h"
+#include "tracker_detection.h"
+
+// Runs detection against a private dbus-daemon where an in-memory Tracker
+// store with the Nepomuk ontology stands in for the indexer. It is exported
+// under the older Tracker3 miner name, so the probe has to fall back past
+// LocalSearch3. Skipped when dbus-daemon is not installed.
+#define INDEXER_SERVICE "org.freedesktop.Tracker3.Miner.Files"
+#define GENERATOR "gnome-screenshot"
+#define WAIT_TIMEOUT_MS 10000
+#define INSERT_INTERVAL_MS 100
+
+// An image as the extractor stores it: the file in the default graph and
+// its metadata in tracker:Pictures.
+static const gchar kInsertImageFormat[] =
+    "INSERT DATA {"
+    "  <%s> a nfo:FileDataObject ;"
+    "    nie:url \"%s\" ;"
+    "    nfo:fileLastModified \"%s\"^^xsd:dateTime ."
+    "  GRAPH tracker:Pictures {"
+    "    <%s> a nfo:Image, nmm:Photo ;"
+    "      nie:isStoredAs <%s> ;"
+    "      nie:generator \"%s\" ."
+    "  }"
+    "}";
+
+// The same for a document, which must not be reported.
+static const gchar kInsertDocumentFormat[] =
+    "INSERT DATA {"
+    "  <%s> a nfo:FileDataObject ;"
+    "    nie:url \"%s\" ;"
+    "    nfo:fileLastModified \"%s\"^^xsd:dateTime ."
+    "  GRAPH tracker:Documents {"
+    "    <%s> a nfo:Document ;"
+    "      nie:isStoredAs <%s> ;"
+    "      nie:generator \"%s\" ."
+    "  }"
+    "}";
+
+typedef struct {
+  GTestDBus* test_bus;
+  GDBusConnection* indexer_bus;
+  TrackerSparqlConnection* store;
+  TrackerEndpointDBus* endpoint;
+  guint n_inserted;
+
+  TrackerDetection* detection;
+  GPtrArray* paths;
+  GPtrArray* generators;
+} Fixture;
+
+static void on_image(const gchar* file_path,
+                     gint64 timestamp_ms,
+                     const gchar* generator,
+                     gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  g_ptr_array_add(fixture->paths, g_strdup(file_path));
+  g_ptr_array_add(fixture->generators, g_strdup(generator));
+}
+
+static void insert_resource(Fixture* fixture,
+                            const gchar* format,
+                            const gchar* name) {
+  guint n = ++fixture->n_inserted;
+  g_autofree gchar* path =
+      g_strdup_printf("/tmp/no-screenshot-test/%s%u.png", name, n);
+  g_autofree gchar* url = g_filename_to_uri(path, NULL, NULL);
+  g_autofree gchar* urn = g_strdup_printf("urn:no-screenshot-test:%u", n);
+  g_autoptr(GDateTime) now = g_date_time_new_now_utc();
+  g_autofree gchar* modified = g_date_time_format_iso8601(now);
+
+  g_autofree gchar* sparql =
+      g_strdup_printf(format, url, url, modified, urn, url, GENERATOR);
+  g_autoptr(GError) error = NULL;
+  tracker_sparql_connection_update(fixture->store, sparql, NULL, &error);
+  g_assert_no_error(error);
+}
+
+// Documents indexed alongside the images are never reported.
+static void insert_document_and_image(gpointer user_data) {
+  Fixture* fixture = (Fixture*)user_data;
+  insert_resource(fixture, kInsertDocumentFormat, "document");
+  insert_resource(fixture, kInsertImageFormat, "screenshot");
+}
+
+static gboolean has_reports(gpointer user_data) {
+  return ((Fixture*)user_data)->paths->len > 0;
+}
+
+static void fixture_setup(Fixture* fixture, gconstpointer data) {
+  // Also points the session bus at the private daemon.
+  fixture->test_bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+  g_test_dbus_up(fixture->test_bus);
+
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) ontology = tracker_sparql_get_ontology_nepomuk();
+  fixture->store = tracker_sparql_connection_new(
+      TRACKER_SPARQL_CONNECTION_FLAGS_NONE, NULL, ontology, NULL, &error);
+  g_assert_no_error(error);
+
+  fixture->indexer_bus = g_dbus_connection_new_for_address_sync(
+      g_test_dbus_get_bus_address(fixture->test_bus),
+      (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+      NULL, NULL, &error);
+  g_assert_no_error(error);
+  fixture->endpoint = tracker_endpoint_dbus_new(
+      fixture->store, fixture->indexer_bus, NULL, NULL, &error);
+  g_assert_no_error(error);
+  g_autoptr(GVariant) reply = g_dbus_connection_call_sync(
+      fixture->indexer_bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+      "org.freedesktop.DBus", "RequestName",
+      g_variant_new("(su)", INDEXER_SERVICE, 0), NULL,
+      G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+  g_assert_no_error(error);
+
+  fixture->paths = g_ptr_array_new_with_free_func(g_free);
+  fixture->generators = g_ptr_array_new_with_free_func(g_free);
+  fixture->detection = tracker_detection_new(NULL, on_image, fixture);
+  tracker_detection_start(fixture->detection);
+}
+
+static void fixture_teardown(Fixture* fixture, gconstpointer data) {
+  tracker_detection_free(fixture->detection);
+  g_ptr_array_unref(fixture->paths);
+  g_ptr_array_unref(fixture->generators);
+  g_object_unref(fixture->endpoint);
+  g_dbus_connection_close_sync(fixture->indexer_bus, NULL, NULL);
+  g_object_unref(fixture->indexer_bus);
+  tracker_sparql_connection_close(fixture->store);
+  g_object_unref(fixture->store);
+  g_test_dbus_down(fixture->test_bus);
+  g_object_unref(fixture->test_bus);
+}
+
+static void test_new_screenshot(Fixture* fixture, gconstpointer data) {
+  g_assert_true(test_probe_until(insert_document_and_image, has_reports,
+                                 fixture, INSERT_INTERVAL_MS,
+                                 WAIT_TIMEOUT_MS));
+  for (guint i = 0; i < fixture->paths->len; i++) {
+    const gchar* reported =
+        (const gchar*)g_ptr_array_index(fixture->paths, i);
+    g_assert_true(
+        g_str_has_prefix(reported, "/tmp/no-screenshot-test/screenshot"));
+    g_assert_cmpstr((const gchar*)g_ptr_array_index(fixture->generators, i),
+                    ==, GENERATOR);
+  }
+}
+
+int main(int argc, char** argv) {
+  g_test_init(&argc, &argv, NULL);
+  if (!test_require_program("dbus-daemon")) return TEST_SKIP_EXIT_CODE;
+
+  g_test_add("/tracker_detection/new-screenshot", Fixture, NULL,
+             fixture_setup, test_new_screenshot, fixture_teardown);
+  return g_test_run();
+}
@@ -0,0 +1,252 @@
+#include "tracker_detection.h"
+
+#include <gio/gio.h>
+
+#include <string.h>
+
+#ifdef NO_SCREENSHOT_HAVE_TRACKER
+#include <libtracker-sparql/tracker-sparql.h>
+#endif
+
+static const gchar* const kIndexerServices[] = {
+    "org.freedesktop.LocalSearch3",          // GNOME 47+
+    "org.freedesktop.Tracker3.Miner.Files",  // Tracker 3
+    NULL,
+};
+
+struct _TrackerDetection {
+  TrackerImageCallback callback;
+  gpointer user_data;
+
+  gchar* service;  // Fixed service, or NULL to probe kIndexerServices.
+
+#ifdef NO_SCREENSHOT_HAVE_TRACKER
+  GCancellable* cancellable;
+  GDBusConnection* bus;
+  int service_index;
+  TrackerSparqlConnection* connection;
+  TrackerNotifier* notifier;
+  gint64 start_time_ms;
+#endif
+};
+
+#ifdef NO_SCREENSHOT_HAVE_TRACKER
+
+// Resolves a batch of new resources to their files in a single query;
+// resources that are not images produce no rows.
+static const gchar kImageQueryFormat[] =
+    "SELECT ?url ?modified ?generator WHERE {"
+    "  VALUES ?urn { %s }"
+    "  ?urn a nfo:Image ; nie:isStoredAs ?file ."
+    "  ?file nie:url ?url ."
+    "  OPTIONAL { ?file nfo:fileLastModified ?modified }"
+    "  OPTIONAL { ?urn nie:generator ?generator }"
+    "}";
+
+static gboolean is_cancelled(const GError* error) {
+  return g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+}
+
+static gint64 parse_iso8601_ms(const gchar* value) {
+  if (value == NULL) return 0;
+  GDateTime* date_time = g_date_time_new_from_iso8601(value, NULL);
+  if (date_time == NULL) return 0;
+  gint64 ms = g_date_time_to_unix(date_time) * 1000 +
+              g_date_time_get_microsecond(date_time) / 1000;
+  g_date_time_unref(date_time);
+  return ms;
+}
+
+static void on_query_ready(GObject* source,
+                           GAsyncResult* result,
+                           gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  TrackerSparqlCursor* cursor = tracker_sparql_connection_query_finish(
+      TRACKER_SPARQL_CONNECTION(source), result, &error);
+  if (cursor == NULL) {
+    if (!is_cancelled(error)) {
+      g_warning("no_screenshot: indexer query failed: %s", error->message);
+    }
+    return;
+  }
+
+  TrackerDetection* self = (TrackerDetection*)user_data;
+  while (tracker_sparql_cursor_next(cursor, NULL, NULL)) {
+    const gchar* url = tracker_sparql_cursor_get_string(cursor, 0, NULL);
+    const gchar* modified = tracker_sparql_cursor_get_string(cursor, 1, NULL);
+    const gchar* generator = tracker_sparql_cursor_get_string(cursor, 2, NULL);
+
+    g_autofree gchar* path = g_filename_from_uri(url, NULL, NULL);
+    if (path == NULL) continue;
+
+    // Files indexed for the first time (e.g. a newly added directory) are
+    // not new captures.
+    gint64 timestamp_ms = parse_iso8601_ms(modified);
+    if (timestamp_ms > 0 && timestamp_ms < self->start_time_ms) continue;
+    if (timestamp_ms <= 0) timestamp_ms = g_get_real_time() / 1000;
+
+    if (self->callback != NULL) {
+      self->callback(path, timestamp_ms, generator ? generator : "",
+                     self->user_data);
+    }
+  }
+  g_object_unref(cursor);
+}
+
+static void on_notifier_events(TrackerNotifier* notifier,
+                               const gchar* service,
+                               const gchar* graph,
+                               GPtrArray* events,
+                               gpointer user_data) {
+  TrackerDetection* self = (TrackerDetection*)user_data;
+
+  // Extracted image metadata lives in the tracker:Pictures graph; file
+  // system crawling produces far more events in other graphs.
+  if (graph != NULL && !g_str_has_suffix(graph, "#Pictures")) return;
+
+  g_autoptr(GString) values = g_string_new(NULL);
+  for (guint i = 0; i < events->len; i++) {
+    TrackerNotifierEvent* event =
+        (TrackerNotifierEvent*)g_ptr_array_index(events, i);
+    if (tracker_notifier_event_get_event_type(event) !=
+        TRACKER_NOTIFIER_EVENT_CREATE) {
+      continue;
+    }
+    const gchar* urn = tracker_notifier_event_get_urn(event);
+    if (urn == NULL || strchr(urn, '>') != NULL) continue;
+    g_string_append_printf(values, "<%s> ", urn);
+  }
+  if (values->len == 0) return;
+
+  g_autofree gchar* sparql = g_strdup_printf(kImageQueryFormat, values->str);
+  tracker_sparql_connection_query_async(self->connection, sparql,
+                                        self->cancellable, on_query_ready,
+                                        self);
+}
+
+static void on_connection_ready(GObject* source,
+                                GAsyncResult* result,
+                                gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  TrackerSparqlConnection* connection =
+      tracker_sparql_connection_bus_new_finish(result, &error);
+  if (connection == NULL) {
+    if (!is_cancelled(error)) {
+      g_warning("no_screenshot: failed to connect to indexer: %s",
+                error->message);
+    }
+    return;
+  }
+
+  TrackerDetection* self = (TrackerDetection*)user_data;
+  self->connection = connection;
+  self->notifier = tracker_sparql_connection_create_notifier(connection);
+  g_signal_connect(self->notifier, "events", G_CALLBACK(on_notifier_events),
+                   self);
+  g_message("no_screenshot: subscribed to desktop search index updates");
+}
+
+static const gchar* current_service(TrackerDetection* self) {
+  if (self->service != NULL) {
+    return self->service_index == 0 ? self->service : NULL;
+  }
+  return kIndexerServices[self->service_index];
+}
+
+static void probe_next_service(TrackerDetection* self);
+
+static void on_name_owner(GObject* source,
+                          GAsyncResult* result,
+                          gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GVariant) reply = g_dbus_connection_call_finish(
+      G_DBUS_CONNECTION(source), result, &error);
+  if (is_cancelled(error)) return;
+
+  TrackerDetection* self = (TrackerDetection*)user_data;
+  if (reply == NULL) {
+    // Not running — try the next known indexer.
+    self->service_index++;
+    probe_next_service(self);
+    return;
+  }
+
+  tracker_sparql_connection_bus_new_async(current_service(self), NULL,
+                                          self->bus, self->cancellable,
+                                          on_connection_ready, self);
+}
+
+static void probe_next_service(TrackerDetection* self) {
+  const gchar* service = current_service(self);
+  if (service == NULL) {
+    g_message("no_screenshot: no desktop search indexer running");
+    return;
+  }
+  g_dbus_connection_call(self->bus, "org.freedesktop.DBus",
+                         "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                         "GetNameOwner", g_variant_new("(s)", service),
+                         G_VARIANT_TYPE("(s)"), G_DBUS_CALL_FLAGS_NONE, -1,
+                         self->cancellable, on_name_owner, self);
+}
+
+static void on_bus_ready(GObject* source,
+                         GAsyncResult* result,
+                         gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+  GDBusConnection* bus = g_bus_get_finish(result, &error);
+  if (bus == NULL) {
+    if (!is_cancelled(error)) {
+      g_warning("no_screenshot: no session bus: %s", error->message);
+    }
+    return;
+  }
+
+  TrackerDetection* self = (TrackerDetection*)user_data;
+  self->bus = bus;
+  self->service_index = 0;
+  probe_next_service(self);
+}
+
+#endif  // NO_SCREENSHOT_HAVE_TRACKER
+
+TrackerDetection* tracker_detection_new(const gchar* service,
+                                        TrackerImageCallback cb,
+                                        gpointer user_data) {
+  TrackerDetection* self = g_new0(TrackerDetection, 1);
+  self->callback = cb;
+  self->user_data = user_data;
+  self->service = g_strdup(service);
+  return self;
+}
+
+void tracker_detection_free(TrackerDetection* self) {
+  if (self == NULL) return;
+  tracker_detection_stop(self);
+  g_free(self->service);
+  g_free(self);
+}
+
+void tracker_detection_start(TrackerDetection* self) {
+#ifdef NO_SCREENSHOT_HAVE_TRACKER
+  if (self->cancellable != NULL) return;  // Already started.
+
+  self->cancellable = g_cancellable_new();
+  self->start_time_ms = g_get_real_time() / 1000;
+  g_bus_get(G_BUS_TYPE_SESSION, self->cancellable, on_bus_ready, self);
+#endif
+}
+
+void tracker_detection_stop(TrackerDetection* self) {
+#ifdef NO_SCREENSHOT_HAVE_TRACKER
+  if (self->cancellable != NULL) {
+    g_cancellable_cancel(self->cancellable);
+    g_clear_object(&self->cancellable);
+  }
+  if (self->notifier != NULL) {
+    g_signal_handlers_disconnect_by_data(self->notifier, self);
+    g_clear_object(&self->notifier);
+  }
+  g_clear_object(&self->connection);
+  g_clear_object(&self->bus);
+#endif
+}
@@ -0,0 +1,35 @@
+#ifndef TRACKER_DETECTION_H_
+#define TRACKER_DETECTION_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Subscribes to the desktop search indexer (LocalSearch / Tracker 3) and
+// reports newly indexed images. The indexer already crawls every indexed
+// directory, so this needs no file watches of its own.
+//
+// Only functional when built against tracker-sparql-3.0
+// (NO_SCREENSHOT_HAVE_TRACKER); otherwise start/stop are no-ops.
+typedef struct _TrackerDetection TrackerDetection;
+
+// Callback invoked for each new image resource. |generator| is the
+// nie:generator metadata of the image (empty when unknown).
+typedef void (*TrackerImageCallback)(const gchar* file_path,
+                                     gint64 timestamp_ms,
+                                     const gchar* generator,
+                                     gpointer user_data);
+
+// |service| is the indexer's D-Bus name, or NULL to use the first running
+// one of org.freedesktop.LocalSearch3 and org.freedesktop.Tracker3.Miner.Files.
+TrackerDetection* tracker_detection_new(const gchar* service,
+                                        TrackerImageCallback cb,
+                                        gpointer user_data);
+void tracker_detection_free(TrackerDetection* self);
+
+void tracker_detection_start(TrackerDetection* self);
+void tracker_detection_stop(TrackerDetection* self);
+
+G_END_DECLS
+
+#endif  // TRACKER_DETECTION_H_
@@ -7,6 +7,7 @@ import 'package:no_screenshot/constants.dart';
 import 'package:no_screenshot/no_screenshot.dart';
 import 'package:no_screenshot/no_screenshot_method_channel.dart';
 import 'package:no_screenshot/no_screenshot_platform_interface.dart';
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 
 void main() {
@@ -373,6 +374,73 @@ void main() {
       expect(true, true);
     });
 
+    test('configureScreenRecordingDetection sends the config', () async {
+      MethodCall? received;
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockMethodCallHandler(channel, (MethodCall methodCall) async {
+            received = methodCall;
+            return null;
+          });
+
+      await platform.configureScreenRecordingDetection(
+        const RecordingDetectionConfig(
+          minInterval: Duration(milliseconds: 250),
+          maxInterval: Duration(seconds: 30),
+          cpuBudget: 0.005,
+          deepScan: true,
+          sessionOnly: true,
+        ),
+      );
+      expect(received?.method, configureScreenRecordingDetectionConst);
+      expect(received?.arguments, {
+        'min_interval_ms': 250,
+        'max_interval_ms': 30000,
+        'cpu_budget': 0.005,
+        'deep_scan': true,
+        'session_only': true,
+      });
+    });
+
+    test('configureScreenshotDetection sends the burst gap', () async {
+      MethodCall? received;
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockMethodCallHandler(channel, (MethodCall methodCall) async {
+            received = methodCall;
+            return null;
+          });
+
+      await platform.configureScreenshotDetection(
+        burstGap: const Duration(milliseconds: 1500),
+      );
+      expect(received?.method, configureScreenshotDetectionConst);
+      expect(received?.arguments, {'burst_gap_ms': 1500});
+    });
+
+    test(
+      'configureScreenshotDetection is a no-op without native support',
+      () async {
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+            .setMockMethodCallHandler(channel, null);
+
+        await expectLater(platform.configureScreenshotDetection(), completes);
+      },
+    );
+
+    test(
+      'configureScreenRecordingDetection is a no-op without native support',
+      () async {
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+            .setMockMethodCallHandler(channel, null);
+
+        await expectLater(
+          platform.configureScreenRecordingDetection(
+            const RecordingDetectionConfig(),
+          ),
+          completes,
+        );
+      },
+    );
+
     test(
       'screenshotStream returns a stream that emits ScreenshotSnapshot',
       () async {
@@ -413,6 +481,32 @@ void main() {
     });
   });
 
+  group('RecordingDetectionConfig', () {
+    test('defaults', () {
+      const config = RecordingDetectionConfig();
+      expect(config.toMap(), {
+        'min_interval_ms': 1000,
+        'max_interval_ms': 16000,
+        'cpu_budget': 0.01,
+        'deep_scan': false,
+        'session_only': false,
+      });
+    });
+
+    test('equality and hashCode', () {
+      const a = RecordingDetectionConfig(cpuBudget: 0.02);
+      const b = RecordingDetectionConfig(cpuBudget: 0.02);
+      const c = RecordingDetectionConfig(maxInterval: Duration(seconds: 5));
+      expect(a, b);
+      expect(a.hashCode, b.hashCode);
+      expect(a == c, isFalse);
+      const d = RecordingDetectionConfig(cpuBudget: 0.02, deepScan: true);
+      const e = RecordingDetectionConfig(cpuBudget: 0.02, sessionOnly: true);
+      expect(a == d, isFalse);
+      expect(a == e, isFalse);
+    });
+  });
+
   group('ScreenshotSnapshot', () {
     test('fromMap', () {
       final map = {
@@ -628,6 +722,141 @@ void main() {
       expect(snapshot1 == snapshot4, false);
     });
 
+    test('fromMap with burst', () {
+      final map = {
+        'screenshot_path': '/example/b.png',
+        'is_screenshot_on': false,
+        'was_screenshot_taken': true,
+        'timestamp': 1700000002000,
+        'source_app': 'GNOME Screenshot',
+        'burst_count': 3,
+        'burst_first_timestamp': 1700000000000,
+        'burst_last_timestamp': 1700000002000,
+        'burst_paths': ['/example/a.png', '/example/b.png'],
+        'is_burst_closed': true,
+      };
+      final snapshot = ScreenshotSnapshot.fromMap(map);
+      expect(snapshot.burstCount, 3);
+      expect(snapshot.burstFirstTimestamp, 1700000000000);
+      expect(snapshot.burstLastTimestamp, 1700000002000);
+      expect(snapshot.burstPaths, ['/example/a.png', '/example/b.png']);
+      expect(snapshot.isBurstClosed, true);
+    });
+
+    test('fromMap without burst defaults burst fields', () {
+      final map = {
+        'screenshot_path': '/example/path',
+        'is_screenshot_on': true,
+        'was_screenshot_taken': true,
+      };
+      final snapshot = ScreenshotSnapshot.fromMap(map);
+      expect(snapshot.burstCount, 0);
+      expect(snapshot.burstFirstTimestamp, 0);
+      expect(snapshot.burstLastTimestamp, 0);
+      expect(snapshot.burstPaths, isEmpty);
+      expect(snapshot.isBurstClosed, false);
+    });
+
+    test('toMap includes burst', () {
+      final snapshot = ScreenshotSnapshot(
+        screenshotPath: '/example/path',
+        isScreenshotProtectionOn: true,
+        wasScreenshotTaken: true,
+        burstCount: 2,
+        burstFirstTimestamp: 1700000000000,
+        burstLastTimestamp: 1700000001000,
+        burstPaths: const ['/example/a.png', '/example/path'],
+        isBurstClosed: true,
+      );
+      final map = snapshot.toMap();
+      expect(map['burst_count'], 2);
+      expect(map['burst_first_timestamp'], 1700000000000);
+      expect(map['burst_last_timestamp'], 1700000001000);
+      expect(map['burst_paths'], ['/example/a.png', '/example/path']);
+      expect(map['is_burst_closed'], true);
+    });
+
+    test('equality with burst', () {
+      final snapshot1 = ScreenshotSnapshot(
+        screenshotPath: '/example/path',
+        isScreenshotProtectionOn: true,
+        wasScreenshotTaken: true,
+        burstCount: 2,
+        burstPaths: const ['/example/a.png', '/example/path'],
+      );
+      final snapshot2 = ScreenshotSnapshot(
+        screenshotPath: '/example/path',
+        isScreenshotProtectionOn: true,
+        wasScreenshotTaken: true,
+        burstCount: 2,
+        burstPaths: ['/example/a.png', '/example/path'],
+      );
+      final snapshot3 = ScreenshotSnapshot(
+        screenshotPath: '/example/path',
+        isScreenshotProtectionOn: true,
+        wasScreenshotTaken: true,
+        burstCount: 2,
+        burstPaths: const ['/example/path'],
+      );
+
+      expect(snapshot1 == snapshot2, true);
+      expect(snapshot1.hashCode, snapshot2.hashCode);
+      expect(snapshot1 == snapshot3, false);
+    });
+
+    test('fromMap with active recorders', () {
+      final map = {
+        'screenshot_path': '',
+        'is_screenshot_on': false,
+        'was_screenshot_taken': false,
+        'is_screen_recording': true,
+        'source_app': 'ffmpeg',
+        'active_recorders': ['obs', 'ffmpeg'],
+      };
+      final snapshot = ScreenshotSnapshot.fromMap(map);
+      expect(snapshot.activeRecorders, ['obs', 'ffmpeg']);
+      expect(snapshot.sourceApp, 'ffmpeg');
+    });
+
+    test('fromMap without active recorders defaults to empty', () {
+      final map = {
+        'screenshot_path': '/example/path',
+        'is_screenshot_on': true,
+        'was_screenshot_taken': true,
+      };
+      final snapshot = ScreenshotSnapshot.fromMap(map);
+      expect(snapshot.activeRecorders, isEmpty);
+    });
+
+    test('toMap and equality include active recorders', () {
+      final snapshot1 = ScreenshotSnapshot(
+        screenshotPath: '',
+        isScreenshotProtectionOn: false,
+        wasScreenshotTaken: false,
+        isScreenRecording: true,
+        activeRecorders: const ['obs', 'ffmpeg'],
+      );
+      final snapshot2 = ScreenshotSnapshot(
+        screenshotPath: '',
+        isScreenshotProtectionOn: false,
+        wasScreenshotTaken: false,
+        isScreenRecording: true,
+        activeRecorders: ['obs', 'ffmpeg'],
+      );
+      final snapshot3 = ScreenshotSnapshot(
+        screenshotPath: '',
+        isScreenshotProtectionOn: false,
+        wasScreenshotTaken: false,
+        isScreenRecording: true,
+        activeRecorders: const ['obs'],
+      );
+
+      expect(snapshot1.toMap()['active_recorders'], ['obs', 'ffmpeg']);
+      expect(snapshot1 == snapshot2, true);
+      expect(snapshot1.hashCode, snapshot2.hashCode);
+      expect(snapshot1 == snapshot3, false);
+    });
+
     test('toString', () {
       final snapshot = ScreenshotSnapshot(
         screenshotPath: '/example/path',
@@ -637,7 +866,7 @@ void main() {
       final string = snapshot.toString();
       expect(
         string,
-        'ScreenshotSnapshot(\nscreenshotPath: /example/path, \nisScreenshotProtectionOn: true, \nwasScreenshotTaken: true, \nisScreenRecording: false, \ntimestamp: 0, \nsourceApp: \n)',
+        'ScreenshotSnapshot(\nscreenshotPath: /example/path, \nisScreenshotProtectionOn: true, \nwasScreenshotTaken: true, \nisScreenRecording: false, \ntimestamp: 0, \nsourceApp: , \nburstCount: 0, \nburstFirstTimestamp: 0, \nburstLastTimestamp: 0, \nburstPaths: [], \nisBurstClosed: false, \nactiveRecorders: []\n)',
       );
     });
 
@@ -651,7 +880,7 @@ void main() {
       final string = snapshot.toString();
       expect(
         string,
-        'ScreenshotSnapshot(\nscreenshotPath: /example/path, \nisScreenshotProtectionOn: true, \nwasScreenshotTaken: true, \nisScreenRecording: true, \ntimestamp: 0, \nsourceApp: \n)',
+        'ScreenshotSnapshot(\nscreenshotPath: /example/path, \nisScreenshotProtectionOn: true, \nwasScreenshotTaken: true, \nisScreenRecording: true, \ntimestamp: 0, \nsourceApp: , \nburstCount: 0, \nburstFirstTimestamp: 0, \nburstLastTimestamp: 0, \nburstPaths: [], \nisBurstClosed: false, \nactiveRecorders: []\n)',
       );
     });
 
@@ -667,6 +896,27 @@ void main() {
       expect(string, contains('timestamp: 1700000000000'));
       expect(string, contains('sourceApp: screencaptureui'));
     });
+
+    test('toString with burst and recorder fields', () {
+      final snapshot = ScreenshotSnapshot(
+        screenshotPath: '/shots/b.png',
+        isScreenshotProtectionOn: true,
+        wasScreenshotTaken: true,
+        burstCount: 2,
+        burstFirstTimestamp: 1700000000000,
+        burstLastTimestamp: 1700000001000,
+        burstPaths: const ['/shots/a.png', '/shots/b.png'],
+        isBurstClosed: true,
+        activeRecorders: const ['obs'],
+      );
+      final string = snapshot.toString();
+      expect(string, contains('burstCount: 2'));
+      expect(string, contains('burstFirstTimestamp: 1700000000000'));
+      expect(string, contains('burstLastTimestamp: 1700000001000'));
+      expect(string, contains('burstPaths: [/shots/a.png, /shots/b.png]'));
+      expect(string, contains('isBurstClosed: true'));
+      expect(string, contains('activeRecorders: [obs]'));
+    });
   });
 
   group('Granular Callbacks (P15)', () {
@@ -1,6 +1,7 @@
 import 'package:flutter_test/flutter_test.dart';
 import 'package:no_screenshot/no_screenshot_method_channel.dart';
 import 'package:no_screenshot/no_screenshot_platform_interface.dart';
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 
 /// A minimal subclass that does NOT override toggleScreenshotWithImage,
@@ -304,5 +305,29 @@ void main() {
         );
       },
     );
+
+    test(
+      'base NoScreenshotPlatform.configureScreenRecordingDetection() throws UnimplementedError',
+      () {
+        final basePlatform = BaseNoScreenshotPlatform();
+        expect(
+          () => basePlatform.configureScreenRecordingDetection(
+            const RecordingDetectionConfig(),
+          ),
+          throwsUnimplementedError,
+        );
+      },
+    );
+
+    test(
+      'base NoScreenshotPlatform.configureScreenshotDetection() throws UnimplementedError',
+      () {
+        final basePlatform = BaseNoScreenshotPlatform();
+        expect(
+          () => basePlatform.configureScreenshotDetection(),
+          throwsUnimplementedError,
+        );
+      },
+    );
   });
 }
@@ -1,6 +1,7 @@
 import 'package:flutter_test/flutter_test.dart';
 import 'package:no_screenshot/no_screenshot_platform_interface.dart';
 import 'package:no_screenshot/no_screenshot_method_channel.dart';
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 import 'package:no_screenshot/no_screenshot.dart';
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
@@ -78,6 +79,26 @@ class MockNoScreenshotPlatform
   Future<void> stopScreenRecordingListening() {
     return Future.value();
   }
+
+  RecordingDetectionConfig? lastRecordingDetectionConfig;
+
+  @override
+  Future<void> configureScreenRecordingDetection(
+    RecordingDetectionConfig config,
+  ) {
+    lastRecordingDetectionConfig = config;
+    return Future.value();
+  }
+
+  Duration? lastBurstGap;
+
+  @override
+  Future<void> configureScreenshotDetection({
+    Duration burstGap = const Duration(seconds: 2),
+  }) {
+    lastBurstGap = burstGap;
+    return Future.value();
+  }
 }
 
 void main() {
@@ -128,6 +149,21 @@ void main() {
     expect(NoScreenshot.instance.stopScreenshotListening(), completes);
   });
 
+  test('configureScreenRecordingDetection', () async {
+    const config = RecordingDetectionConfig(
+      minInterval: Duration(milliseconds: 500),
+    );
+    await NoScreenshot.instance.configureScreenRecordingDetection(config);
+    expect(fakePlatform.lastRecordingDetectionConfig, config);
+  });
+
+  test('configureScreenshotDetection', () async {
+    await NoScreenshot.instance.configureScreenshotDetection(
+      burstGap: const Duration(seconds: 5),
+    );
+    expect(fakePlatform.lastBurstGap, const Duration(seconds: 5));
+  });
+
   test('toggleScreenshotWithImage', () async {
     expect(await NoScreenshot.instance.toggleScreenshotWithImage(), true);
   });
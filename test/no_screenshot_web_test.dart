@@ -3,6 +3,7 @@ library;
 
 import 'package:flutter_test/flutter_test.dart';
 import 'package:no_screenshot/no_screenshot_web.dart';
+import 'package:no_screenshot/recording_detection_config.dart';
 import 'package:no_screenshot/screenshot_snapshot.dart';
 
 void main() {
@@ -102,6 +103,19 @@ void main() {
       await expectLater(platform.stopScreenRecordingListening(), completes);
     });
 
+    test('configureScreenshotDetection completes (no-op)', () async {
+      await expectLater(platform.configureScreenshotDetection(), completes);
+    });
+
+    test('configureScreenRecordingDetection completes (no-op)', () async {
+      await expectLater(
+        platform.configureScreenRecordingDetection(
+          const RecordingDetectionConfig(),
+        ),
+        completes,
+      );
+    });
+
     test('screenshotStream emits on state changes', () async {
       final events = <ScreenshotSnapshot>[];
       platform.screenshotStream.listen(events.add);